@@ -9,6 +9,9 @@
 #include "ns3/random-variable-stream.h"
 #include <iomanip>
 #include <iostream>
+#include <chrono>
+#include <memory>
+#include "run-performance.h"
 
 using namespace ns3;
 
@@ -89,12 +92,29 @@ int main(int argc, char *argv[])
   uint32_t numNodes = 15;      // total nodes (last is attacker)
   double simTime = 30.0;
   bool enablePcap = true;
+  bool lean = false;
+  bool perfReport = false;
+  bool comparePerf = false;
 
   CommandLine cmd;
   cmd.AddValue("enablePcap", "Enable PCAP tracing", enablePcap);
+  cmd.AddValue("lean", "Headless batch mode: no NetAnim, PCAP or logging, counters only", lean);
+  cmd.AddValue("perfReport", "Report run time and peak memory", perfReport);
+  cmd.AddValue("comparePerf", "Run full and then lean in child processes and print the ratios", comparePerf);
   cmd.Parse(argc, argv);
 
-  LogComponentEnable("FloodingAttackSimulation", LOG_LEVEL_INFO);
+  if (comparePerf) {
+    perfReport = true;
+    if (!ForkPerfComparison(lean)) {
+      return 0;
+    }
+  }
+
+  if (lean) {
+    enablePcap = false;
+  } else {
+    LogComponentEnable("FloodingAttackSimulation", LOG_LEVEL_INFO);
+  }
 
   // Create nodes
   NodeContainer nodes;
@@ -173,19 +193,24 @@ int main(int argc, char *argv[])
     std::cout << "PCAP enabled for flood analysis" << std::endl;
   }
 
-  // NetAnim visualization
-  AnimationInterface anim("flooding-attack.xml");
-  for (uint32_t i = 0; i < numNodes - 1; ++i) {
-    anim.UpdateNodeColor(nodes.Get(i), 0, 255, 0);  // green normal
-    anim.UpdateNodeSize(nodes.Get(i)->GetId(), 25, 25);
+  // NetAnim visualization (it tags every packet, so not in lean mode)
+  std::unique_ptr<AnimationInterface> anim;
+  if (!lean) {
+    anim = std::make_unique<AnimationInterface>("flooding-attack.xml");
+    for (uint32_t i = 0; i < numNodes - 1; ++i) {
+      anim->UpdateNodeColor(nodes.Get(i), 0, 255, 0);  // green normal
+      anim->UpdateNodeSize(nodes.Get(i)->GetId(), 25, 25);
+    }
+    anim->UpdateNodeColor(attacker, 255, 0, 0);  // red attacker
+    anim->UpdateNodeSize(attacker->GetId(), 35, 35);
   }
-  anim.UpdateNodeColor(attacker, 255, 0, 0);  // red attacker
-   anim.UpdateNodeSize(attacker->GetId(), 35, 35);      
-
 
   // Run simulation
   Simulator::Stop(Seconds(simTime));
+  auto wallStart = std::chrono::steady_clock::now();
   Simulator::Run();
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  anim.reset();
   Simulator::Destroy();
 
   // Output results
@@ -200,6 +225,10 @@ int main(int argc, char *argv[])
   std::cout << "Attack Rate (pkt/sec):       " << std::fixed << std::setprecision(2) << attackRate << "\n";
   std::cout << "======================================\n";
 
+  if (lean || perfReport) {
+    PrintRunPerformance(lean, wallSeconds);
+  }
+
   return 0;
 }
 
@@ -8,10 +8,27 @@
 #include "ns3/netanim-module.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/aodv-packet.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/energy-module.h"
+#include "manet-common.h"
+#include "run-performance.h"
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <deque>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <iterator>
+#include <chrono>
+#include <memory>
 
 using namespace ns3;
 
@@ -26,14 +43,39 @@ uint32_t g_totalRreqsReceived = 0;
 uint32_t g_legitimateRreqs = 0;
 
 // -------------------- Advanced Defense Manager --------------------
+// Per-node RREQ rate limiter over RateLimitCore: 3 RREQs per source and
+// second, a source is flagged after 10 violations
 class AdvancedDefenseManager : public Object
 {
 private:
-  std::map<Ipv4Address, std::deque<Time>> m_rreqTimes;
-  std::map<Ipv4Address, uint32_t> m_suspiciousActivity;
-  uint32_t m_rreqLimit = 3;            // Max 3 RREQs/sec per source
-  double   m_timeWindow = 1.0;         // 1-second window
-  uint32_t m_suspiciousThreshold = 10; // Flag after 10 violations
+  RateLimitCore m_core;
+  Callback<void, Ipv4Address> m_blacklistCallback;
+  EventId m_flushEvent;
+
+  void OnFlagged(Ipv4Address source)
+  {
+    RecordDetection(source);
+    if (!m_blacklistCallback.IsNull()) m_blacklistCallback(source);
+  }
+
+  // Counts one verdict; true if the RREQ is accepted
+  bool Apply(Ipv4Address source, RateLimitCore::Verdict verdict)
+  {
+    g_totalRreqsReceived++;
+    RecordVerdict(source, verdict == RateLimitCore::ACCEPT);
+    if (verdict == RateLimitCore::ACCEPT) {
+      g_legitimateRreqs++;
+      return true;
+    }
+    g_rreqsDropped++;
+    if (verdict == RateLimitCore::FLAGGED) {
+      NS_LOG_INFO("Blocking RREQ from flagged malicious source " << source);
+    } else {
+      NS_LOG_INFO("RREQ rate limit exceeded for " << source
+                  << " (violations: " << m_core.ViolationsOf(source) << ") - dropping");
+    }
+    return false;
+  }
 
 public:
   static TypeId GetTypeId(void)
@@ -44,67 +86,1016 @@ public:
     return tid;
   }
 
-  bool ShouldAcceptRREQ(Ipv4Address source)
+  AdvancedDefenseManager()
   {
-    Time now = Simulator::Now();
-    g_totalRreqsReceived++;
+    m_core.onFlagged = MakeCallback(&AdvancedDefenseManager::OnFlagged, this);
+  }
 
-    // If already flagged malicious, drop immediately
-    auto suspIt = m_suspiciousActivity.find(source);
-    if (suspIt != m_suspiciousActivity.end() && suspIt->second >= m_suspiciousThreshold) {
-      g_rreqsDropped++;
-      NS_LOG_INFO("Blocking RREQ from flagged malicious source " << source);
-      return false;
-    }
+  bool ShouldAcceptRREQ(Ipv4Address source) { return ShouldAcceptRREQ(source, Simulator::Now()); }
 
-    // Rate limiting
-    auto &times = m_rreqTimes[source];
-    while (!times.empty() && (now - times.front()).GetSeconds() > m_timeWindow) {
-      times.pop_front();
-    }
-    if (times.size() >= m_rreqLimit) {
-      g_rreqsDropped++;
-      m_suspiciousActivity[source]++;
-      NS_LOG_INFO("RREQ rate limit exceeded for " << source
-                  << " (violations: " << m_suspiciousActivity[source] << ") - dropping");
-      return false;
+  bool ShouldAcceptRREQ(Ipv4Address source, Time now) { return Apply(source, m_core.Judge(source, now)); }
+
+  // Batched mode: queue the arrival; its verdict is applied when the tick ends
+  void EnqueueRREQ(Ipv4Address source)
+  {
+    EnqueueRREQ(source, Simulator::Now());
+    if (!m_flushEvent.IsRunning()) {
+      m_flushEvent = Simulator::Schedule(g_batchTick, &AdvancedDefenseManager::FlushBatch, this);
     }
+  }
+
+  void EnqueueRREQ(Ipv4Address source, Time now) { m_core.Enqueue(source, now); }
 
-    times.push_back(now);
-    g_legitimateRreqs++;
+  void FlushBatch()
+  {
+    auto begin = std::chrono::steady_clock::now();
+    size_t arrivals = m_core.Flush([this](Ipv4Address source, RateLimitCore::Verdict verdict) {
+      Apply(source, verdict);
+    });
+    RecordRealtimeFlush(begin, arrivals);
+  }
+
+  // Pre-emptively flag a source reported by a neighbour; false if already flagged
+  bool Quarantine(Ipv4Address source)
+  {
+    if (!m_core.Quarantine(source)) return false;
+    RecordDetection(source);
+    NS_LOG_INFO("Quarantining " << source << " on neighbour report");
     return true;
   }
 
-  void PrintSecurityReport()
+  // Invoked once per source when it crosses the violation threshold
+  void SetBlacklistCallback(Callback<void, Ipv4Address> cb) { m_blacklistCallback = cb; }
+
+  bool HasActivity() const { return m_core.HasActivity(); }
+
+  uint32_t GetTrackedSources() const { return m_core.TrackedSources(); }
+
+  uint32_t GetFlaggedSources() const { return m_core.FlaggedSources(); }
+
+  void PrintSecurityReport(const std::string &label = "")
   {
-    std::cout << "\n========== Security Analysis Report ==========" << std::endl;
-    std::cout << "Suspicious Sources Detected: " << m_suspiciousActivity.size() << std::endl;
-    for (auto &entry : m_suspiciousActivity) {
-      std::string level = (entry.second >= m_suspiciousThreshold ? "HIGH"
+    std::cout << "\n========== Security Analysis Report " << label << "==========" << std::endl;
+    std::cout << "Suspicious Sources Detected: " << m_core.Violations().size() << std::endl;
+    for (auto &entry : m_core.Violations()) {
+      std::string level = (entry.second >= m_core.threshold ? "HIGH"
                            : (entry.second >= 5 ? "MEDIUM" : "LOW"));
       std::cout << "  " << entry.first 
                 << " - Violations: " << entry.second 
                 << " (Threat: " << level << ")" << std::endl;
     }
+    if (!m_core.Quarantined().empty()) {
+      std::cout << "Quarantined on Neighbour Report: " << m_core.Quarantined().size() << std::endl;
+      for (const Ipv4Address &source : m_core.Quarantined()) {
+        std::cout << "  " << source << std::endl;
+      }
+    }
     std::cout << "===============================================" << std::endl;
   }
 };
 
-Ptr<AdvancedDefenseManager> g_defenseManager;
+// One manager per node; in shared mode every entry points at the same instance
+std::vector<Ptr<AdvancedDefenseManager>> g_defenseManagers;
+
+bool QuarantineSource(Ptr<AdvancedDefenseManager> manager, Ipv4Address source)
+{
+  if (!manager->Quarantine(source)) return false;
+  RecordIsolation(source);
+  return true;
+}
 
 // -------------------- Trace callbacks --------------------
 void TxCallback(Ptr<const Packet>) { g_packetsSent++; }
 void RxCallback(Ptr<const Packet>) { g_packetsReceived++; }
 
-void AdvancedAodvRxCallback(Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t)
+// Runs the rate limiter for one source
+bool DefenseAccepts(Ptr<AdvancedDefenseManager> manager, Ipv4Address source)
+{
+  bool accepted = true;
+  if (g_batchTick.IsStrictlyPositive()) {
+    manager->EnqueueRREQ(source); // verdict applied (and timed) at the end of the tick
+  } else {
+    auto begin = std::chrono::steady_clock::now();
+    accepted = manager->ShouldAcceptRREQ(source);
+    if (g_realtime.enabled) RecordRealtimeDecision(begin);
+  }
+  if (!accepted) {
+    NS_LOG_INFO("Defensive action: Dropped suspicious packet from " << source);
+    return false;
+  }
+  return true;
+}
+
+// Runs the defense on an IPv4 packet (header included), keyed on its source
+bool DefenseAccepts(Ptr<AdvancedDefenseManager> manager, Ptr<const Packet> p)
 {
   Ptr<Packet> copy = p->Copy();
   Ipv4Header hdr;
-  if (!copy->RemoveHeader(hdr)) return;
-  Ipv4Address source = hdr.GetSource();
-  if (!g_defenseManager->ShouldAcceptRREQ(source)) {
-    NS_LOG_INFO("Defensive action: Dropped suspicious packet from " << source);
+  if (!copy->RemoveHeader(hdr)) return true;
+  UdpHeader udp;
+  if (hdr.GetProtocol() == UdpL4Protocol::PROT_NUMBER && copy->PeekHeader(udp)
+      && udp.GetDestinationPort() == g_gossipPort) {
+    return true; // defense control traffic
+  }
+  return DefenseAccepts(manager, hdr.GetSource());
+}
+
+void AdvancedAodvRxCallback(Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t)
+{
+  DefenseAccepts(g_defenseManagers[ipv4->GetObject<Node>()->GetId()], p);
+}
+
+// -------------------- Node processing-capacity model --------------------
+// Optional per-node CPU: every IPv4 and ARP frame the node receives on its
+// Wi-Fi device waits in a bounded FIFO and is served one at a time with a
+// per-class cost before traffic control, IPv4 and AODV see it. The model
+// stands in for traffic control's protocol handlers on that device and
+// hands each served frame back to them with the node's own arguments.
+// With the defense enabled, every RREQ gets an in-path verdict keyed on
+// its originator at service start, charged against the same budget;
+// rejected RREQs skip the protocol cost. Data and other control pass.
+// This is the only mode in which the defense drops packets.
+class NodeCpuModel : public Object
+{
+public:
+  enum PacketClass { CLASS_RREQ = 0, CLASS_CONTROL, CLASS_DATA, CLASS_COUNT };
+
+  struct ClassStats
+  {
+    uint64_t arrived = 0;
+    uint64_t served = 0;
+    uint64_t dropped = 0;   // service queue full
+    uint64_t filtered = 0;  // rejected by the defense
+    Time queueDelay;
+    Time maxQueueDelay;
+  };
+
+  // Shared across nodes so the report covers the whole network
+  static ClassStats s_stats[CLASS_COUNT];
+  static Time s_busyTime;
+  static Time s_defenseTime;
+  static Time s_savedTime;
+
+  static Time s_cost[CLASS_COUNT];
+  static Time s_defenseCost;
+  static uint32_t s_queueLimit;
+
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("NodeCpuModel")
+      .SetParent<Object>()
+      .AddConstructor<NodeCpuModel>();
+    return tid;
+  }
+
+  // Call after the IPv4 interfaces exist, so traffic control's handlers are registered
+  void Install(Ptr<Node> node, Ptr<NetDevice> device, Ptr<AdvancedDefenseManager> manager)
+  {
+    m_deliver = MakeCallback(&TrafficControlLayer::Receive, node->GetObject<TrafficControlLayer>());
+    m_manager = manager;
+    // Unregistering drops traffic control's handlers on every device; put
+    // them back everywhere except the Wi-Fi device, which goes through us
+    node->UnregisterProtocolHandler(m_deliver);
+    for (uint32_t i = 0; i < node->GetNDevices(); ++i) {
+      Ptr<NetDevice> dev = node->GetDevice(i);
+      Node::ProtocolHandler handler = m_deliver;
+      if (dev == device) {
+        handler = MakeCallback(&NodeCpuModel::Receive, this);
+      } else if (node->GetObject<Ipv6>()) {
+        node->RegisterProtocolHandler(handler, Ipv6L3Protocol::PROT_NUMBER, dev);
+      }
+      node->RegisterProtocolHandler(handler, Ipv4L3Protocol::PROT_NUMBER, dev);
+      node->RegisterProtocolHandler(handler, ArpL3Protocol::PROT_NUMBER, dev);
+    }
+  }
+
+  static const char *ClassName(uint32_t c)
+  {
+    static const char *names[CLASS_COUNT] = {"RREQ", "RREP/RERR", "DATA"};
+    return names[c];
+  }
+
+private:
+  struct Job
+  {
+    Ptr<NetDevice> device;
+    Ptr<const Packet> packet;
+    uint16_t protocol;
+    Address from;
+    Address to;
+    NetDevice::PacketType packetType;
+    PacketClass cls;
+    Ipv4Address originator; // RREQs only
+    Time arrival;
+  };
+
+  static PacketClass Classify(Ptr<const Packet> p, uint16_t protocol, Ipv4Address &originator)
+  {
+    if (protocol != Ipv4L3Protocol::PROT_NUMBER) return CLASS_DATA;
+    Ptr<Packet> copy = p->Copy();
+    Ipv4Header ip;
+    UdpHeader udp;
+    if (!copy->RemoveHeader(ip) || ip.GetProtocol() != UdpL4Protocol::PROT_NUMBER
+        || !copy->RemoveHeader(udp) || udp.GetDestinationPort() != aodv::RoutingProtocol::AODV_PORT) {
+      return CLASS_DATA;
+    }
+    aodv::TypeHeader type;
+    copy->RemoveHeader(type);
+    if (!type.IsValid() || type.Get() != aodv::AODVTYPE_RREQ) return CLASS_CONTROL;
+    aodv::RreqHeader rreq;
+    copy->RemoveHeader(rreq);
+    originator = rreq.GetOrigin();
+    return CLASS_RREQ;
+  }
+
+  void Receive(Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from,
+               const Address &to, NetDevice::PacketType packetType)
+  {
+    Ipv4Address originator;
+    PacketClass cls = Classify(p, protocol, originator);
+    s_stats[cls].arrived++;
+    if (m_queue.size() >= s_queueLimit) {
+      s_stats[cls].dropped++;
+      return;
+    }
+    m_queue.push_back({device, p, protocol, from, to, packetType, cls, originator, Simulator::Now()});
+    if (!m_busy) StartService();
+  }
+
+  void StartService()
+  {
+    if (m_queue.empty()) {
+      m_busy = false;
+      return;
+    }
+    m_busy = true;
+    Job &job = m_queue.front();
+    Time delay = Simulator::Now() - job.arrival;
+    ClassStats &stats = s_stats[job.cls];
+    stats.queueDelay += delay;
+    stats.maxQueueDelay = std::max(stats.maxQueueDelay, delay);
+
+    Time cost = s_cost[job.cls];
+    bool deliver = true;
+    if (m_manager && job.cls == CLASS_RREQ) {
+      s_defenseTime += s_defenseCost;
+      if (!DefenseAccepts(m_manager, job.originator)) {
+        deliver = false;
+        stats.filtered++;
+        s_savedTime += cost;
+        cost = Time(0);
+      }
+      cost += s_defenseCost;
+    }
+    s_busyTime += cost;
+    Simulator::Schedule(cost, &NodeCpuModel::FinishService, this, deliver);
+  }
+
+  void FinishService(bool deliver)
+  {
+    Job job = m_queue.front();
+    m_queue.pop_front();
+    if (deliver) {
+      s_stats[job.cls].served++;
+      m_deliver(job.device, job.packet, job.protocol, job.from, job.to, job.packetType);
+    }
+    StartService();
+  }
+
+  Node::ProtocolHandler m_deliver; // traffic control's handler for the Wi-Fi device
+  Ptr<AdvancedDefenseManager> m_manager;
+  std::deque<Job> m_queue;
+  bool m_busy = false;
+};
+
+NodeCpuModel::ClassStats NodeCpuModel::s_stats[NodeCpuModel::CLASS_COUNT];
+Time NodeCpuModel::s_busyTime;
+Time NodeCpuModel::s_defenseTime;
+Time NodeCpuModel::s_savedTime;
+Time NodeCpuModel::s_cost[NodeCpuModel::CLASS_COUNT];
+Time NodeCpuModel::s_defenseCost;
+uint32_t NodeCpuModel::s_queueLimit = 50;
+
+void PrintCpuReport(uint32_t cpuNodes, double simTime)
+{
+  std::cout << "\n========== Node Processing Report ==========" << std::endl;
+  for (uint32_t c = 0; c < NodeCpuModel::CLASS_COUNT; ++c) {
+    const NodeCpuModel::ClassStats &s = NodeCpuModel::s_stats[c];
+    uint64_t started = s.served + s.filtered;
+    double avgDelayMs = started ? s.queueDelay.GetSeconds() * 1000.0 / started : 0.0;
+    std::cout << std::setw(10) << NodeCpuModel::ClassName(c)
+              << ": arrived " << s.arrived << ", served " << s.served
+              << ", filtered " << s.filtered << ", queue drops " << s.dropped
+              << ", avg/max queue delay " << std::fixed << std::setprecision(3) << avgDelayMs
+              << "/" << s.maxQueueDelay.GetSeconds() * 1000.0 << " ms" << std::endl;
+  }
+  double capacity = cpuNodes * simTime;
+  std::cout << "CPU Utilization (%):         " << std::setprecision(2)
+            << (capacity > 0 ? 100.0 * NodeCpuModel::s_busyTime.GetSeconds() / capacity : 0.0) << std::endl;
+  std::cout << "Defense CPU Cost (s):        " << std::setprecision(4)
+            << NodeCpuModel::s_defenseTime.GetSeconds() << std::endl;
+  std::cout << "Protocol CPU Saved (s):      " << NodeCpuModel::s_savedTime.GetSeconds() << std::endl;
+  std::cout << "============================================" << std::endl;
+}
+
+// -------------------- Fair queueing at the device --------------------
+// Optional root queue disc for normal nodes: deficit round robin over
+// per-originator flows, with AODV control and data in separate classes. An
+// RREQ's originator is read from the AODV header, so a flood rebroadcast by
+// neighbours still lands in the flooder's flow. Each backlogged originator
+// holds a bucket of its own until it drains; once a class runs out of
+// buckets, further originators share its overflow bucket and are counted.
+// When the disc is full the head of the longest flow is dropped, so one
+// abusive originator cannot take a node's transmit capacity.
+class FairControlQueueDisc : public QueueDisc
+{
+public:
+  enum TrafficClass { CLASS_CONTROL = 0, CLASS_DATA, CLASS_COUNT };
+
+  struct ClassStats
+  {
+    uint64_t enqueued = 0;
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+    uint64_t shared = 0; // packets put in the overflow bucket
+    Time queueDelay;
+    Time maxQueueDelay;
+  };
+  static ClassStats s_stats[CLASS_COUNT];
+
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("FairControlQueueDisc")
+      .SetParent<QueueDisc>()
+      .AddConstructor<FairControlQueueDisc>()
+      .AddAttribute("MaxSize", "Packets held across all flows",
+                    QueueSizeValue(QueueSize("100p")),
+                    MakeQueueSizeAccessor(&QueueDisc::SetMaxSize, &QueueDisc::GetMaxSize),
+                    MakeQueueSizeChecker())
+      .AddAttribute("Flows", "Backlogged originators tracked per traffic class",
+                    UintegerValue(32),
+                    MakeUintegerAccessor(&FairControlQueueDisc::m_flowsPerClass),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("Quantum", "Bytes a flow may send per round",
+                    UintegerValue(600),
+                    MakeUintegerAccessor(&FairControlQueueDisc::m_quantum),
+                    MakeUintegerChecker<uint32_t>(1));
+    return tid;
+  }
+
+  FairControlQueueDisc() : QueueDisc(QueueDiscSizePolicy::MULTIPLE_QUEUES, QueueSizeUnit::PACKETS) {}
+
+  static const char *ClassName(uint32_t c)
+  {
+    static const char *names[CLASS_COUNT] = {"AODV", "DATA"};
+    return names[c];
+  }
+
+private:
+  struct Flow
+  {
+    TrafficClass cls = CLASS_DATA;
+    int32_t deficit = 0;
+    bool active = false;
+    bool owned = false; // bound to originator in m_owners
+    uint32_t originator = 0;
+  };
+
+  uint32_t BucketsPerClass() const { return m_flowsPerClass + 1; }
+
+  // Bucket of (cls, originator), binding a free one on first use
+  uint32_t FlowFor(TrafficClass cls, Ipv4Address originator)
+  {
+    std::pair<uint32_t, uint32_t> key(cls, originator.Get());
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t>::const_iterator it = m_owners.find(key);
+    if (it != m_owners.end()) return it->second;
+    if (m_free[cls].empty()) {
+      s_stats[cls].shared++;
+      return cls * BucketsPerClass() + m_flowsPerClass;
+    }
+    uint32_t index = m_free[cls].back();
+    m_free[cls].pop_back();
+    m_owners[key] = index;
+    m_flows[index].owned = true;
+    m_flows[index].originator = originator.Get();
+    return index;
+  }
+
+  void ReleaseFlow(uint32_t index)
+  {
+    Flow &flow = m_flows[index];
+    if (!flow.owned) return;
+    m_owners.erase(std::make_pair(static_cast<uint32_t>(flow.cls), flow.originator));
+    m_free[flow.cls].push_back(index);
+    flow.owned = false;
+  }
+
+  static TrafficClass Classify(Ptr<QueueDiscItem> item, Ipv4Address &originator)
+  {
+    Ptr<Ipv4QueueDiscItem> ipItem = DynamicCast<Ipv4QueueDiscItem>(item);
+    if (!ipItem) return CLASS_DATA; // ARP
+    const Ipv4Header &ip = ipItem->GetHeader();
+    originator = ip.GetSource();
+    Ptr<Packet> copy = item->GetPacket()->Copy();
+    UdpHeader udp;
+    if (ip.GetProtocol() != UdpL4Protocol::PROT_NUMBER || !copy->RemoveHeader(udp)
+        || udp.GetDestinationPort() != aodv::RoutingProtocol::AODV_PORT) {
+      return CLASS_DATA;
+    }
+    aodv::TypeHeader type;
+    aodv::RreqHeader rreq;
+    if (copy->RemoveHeader(type) && type.IsValid() && type.Get() == aodv::AODVTYPE_RREQ
+        && copy->RemoveHeader(rreq)) {
+      originator = rreq.GetOrigin();
+    }
+    return CLASS_CONTROL;
+  }
+
+  bool DoEnqueue(Ptr<QueueDiscItem> item) override
+  {
+    Ipv4Address originator;
+    TrafficClass cls = Classify(item, originator);
+    uint32_t index = FlowFor(cls, originator);
+    Flow &flow = m_flows[index];
+    if (!GetQueueDiscClass(index)->GetQueueDisc()->Enqueue(item)) {
+      if (!flow.active) ReleaseFlow(index);
+      return false;
+    }
+
+    s_stats[cls].enqueued++;
+    if (!flow.active) {
+      flow.active = true;
+      flow.deficit = m_quantum;
+      m_round.push_back(index);
+    }
+    if (GetCurrentSize() > GetMaxSize()) DropFromLongestFlow();
+    return true;
+  }
+
+  Ptr<QueueDiscItem> DoDequeue(void) override
+  {
+    while (!m_round.empty()) {
+      uint32_t index = m_round.front();
+      Flow &flow = m_flows[index];
+      Ptr<QueueDisc> qd = GetQueueDiscClass(index)->GetQueueDisc();
+      Ptr<const QueueDiscItem> head = qd->Peek();
+      if (!head) {
+        flow.active = false;
+        ReleaseFlow(index);
+        m_round.pop_front();
+        continue;
+      }
+      if (flow.deficit < static_cast<int32_t>(head->GetSize())) {
+        flow.deficit += m_quantum;
+        m_round.pop_front();
+        m_round.push_back(index);
+        continue;
+      }
+      Ptr<QueueDiscItem> item = qd->Dequeue();
+      flow.deficit -= item->GetSize();
+      ClassStats &stats = s_stats[flow.cls];
+      Time delay = Simulator::Now() - item->GetTimeStamp();
+      stats.sent++;
+      stats.queueDelay += delay;
+      stats.maxQueueDelay = std::max(stats.maxQueueDelay, delay);
+      return item;
+    }
+    return 0;
+  }
+
+  void DropFromLongestFlow()
+  {
+    uint32_t longest = 0;
+    for (uint32_t i = 1; i < m_flows.size(); ++i) {
+      if (GetQueueDiscClass(i)->GetQueueDisc()->GetNPackets()
+          > GetQueueDiscClass(longest)->GetQueueDisc()->GetNPackets()) {
+        longest = i;
+      }
+    }
+    Ptr<QueueDiscItem> item = GetQueueDiscClass(longest)->GetQueueDisc()->Dequeue();
+    s_stats[m_flows[longest].cls].dropped++;
+    DropAfterDequeue(item, "Longest flow drop");
+  }
+
+  bool CheckConfig(void) override
+  {
+    return GetNQueueDiscClasses() == 0 && GetNInternalQueues() == 0 && GetNPacketFilters() == 0;
+  }
+
+  // One FIFO child per bucket, the last of each class being the overflow
+  // bucket; the parent enforces MaxSize
+  void InitializeParams(void) override
+  {
+    ObjectFactory factory;
+    factory.SetTypeId("ns3::FifoQueueDisc");
+    factory.Set("MaxSize", QueueSizeValue(GetMaxSize()));
+    m_flows.assign(CLASS_COUNT * BucketsPerClass(), Flow());
+    for (uint32_t i = 0; i < CLASS_COUNT * BucketsPerClass(); ++i) {
+      Ptr<QueueDisc> qd = factory.Create<QueueDisc>();
+      qd->Initialize();
+      Ptr<QueueDiscClass> c = CreateObject<QueueDiscClass>();
+      c->SetQueueDisc(qd);
+      AddQueueDiscClass(c);
+      uint32_t cls = i / BucketsPerClass();
+      m_flows[i].cls = static_cast<TrafficClass>(cls);
+      if (i % BucketsPerClass() != m_flowsPerClass) m_free[cls].push_back(i);
+    }
+  }
+
+  uint32_t m_flowsPerClass;
+  uint32_t m_quantum;
+  std::vector<Flow> m_flows;
+  std::deque<uint32_t> m_round;
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> m_owners; // (class, originator) -> bucket
+  std::vector<uint32_t> m_free[CLASS_COUNT];
+};
+
+FairControlQueueDisc::ClassStats FairControlQueueDisc::s_stats[FairControlQueueDisc::CLASS_COUNT];
+NS_OBJECT_ENSURE_REGISTERED(FairControlQueueDisc);
+
+void PrintFairQueueReport()
+{
+  std::cout << "\n========== Device Fair Queueing Report ==========" << std::endl;
+  for (uint32_t c = 0; c < FairControlQueueDisc::CLASS_COUNT; ++c) {
+    const FairControlQueueDisc::ClassStats &s = FairControlQueueDisc::s_stats[c];
+    double avgDelayMs = s.sent ? s.queueDelay.GetSeconds() * 1000.0 / s.sent : 0.0;
+    double dropPct = s.enqueued ? 100.0 * s.dropped / s.enqueued : 0.0;
+    std::cout << std::setw(6) << FairControlQueueDisc::ClassName(c)
+              << ": enqueued " << s.enqueued << ", sent " << s.sent
+              << ", dropped " << s.dropped << " (" << std::fixed << std::setprecision(2) << dropPct << "%)"
+              << ", overflow bucket " << s.shared
+              << ", avg/max queue delay " << std::setprecision(3) << avgDelayMs
+              << "/" << s.maxQueueDelay.GetSeconds() * 1000.0 << " ms" << std::endl;
+  }
+  std::cout << "=================================================" << std::endl;
+}
+
+// -------------------- AODV instrumentation --------------------
+// Samples stock AODV state on every node. The routing table size is parsed
+// from PrintRoutingTable output. The RREQ-ID cache and request queue are
+// private in aodv::RoutingProtocol, so they are estimates mirrored from
+// IPv4 traces: the cache by replaying IdCache semantics (origin, id) with
+// PathDiscoveryTime lifetime, the queue as deferred (loopback) packets
+// minus those later forwarded or dropped with DROP_ROUTE_ERROR. The CSV
+// and report name them as estimates.
+struct AodvNodeStats
+{
+  Ptr<Ipv4> ipv4;
+  Ptr<aodv::RoutingProtocol> aodv;
+  Time pathDiscoveryTime;
+  std::map<std::pair<uint32_t, uint32_t>, Time> rreqIdCache;
+  uint64_t rreqRx = 0;
+  uint64_t rreqFwd = 0;
+  uint64_t rreqOriginated = 0;
+  uint64_t deferred = 0;
+  uint64_t dequeued = 0;
+  uint64_t queueDrops = 0;
+  uint32_t maxRoutes = 0;
+  uint64_t maxIdCacheEst = 0;
+  uint64_t maxQueueEst = 0;
+};
+
+std::vector<AodvNodeStats> g_aodvStats;
+std::ofstream g_aodvStatsFile;
+
+// Extracts the RREQ from an IPv4 packet (header included), if it is one
+bool ParseRreq(Ptr<const Packet> p, Ipv4Header &ip, aodv::RreqHeader &rreq)
+{
+  Ptr<Packet> copy = p->Copy();
+  UdpHeader udp;
+  aodv::TypeHeader type;
+  if (!copy->RemoveHeader(ip) || ip.GetProtocol() != UdpL4Protocol::PROT_NUMBER
+      || !copy->RemoveHeader(udp) || udp.GetDestinationPort() != aodv::RoutingProtocol::AODV_PORT
+      || !copy->RemoveHeader(type) || !type.IsValid() || type.Get() != aodv::AODVTYPE_RREQ) {
+    return false;
+  }
+  return copy->RemoveHeader(rreq) > 0;
+}
+
+bool IsLocal(Ptr<Ipv4> ipv4, Ipv4Address addr)
+{
+  return ipv4->GetInterfaceForAddress(addr) >= 0;
+}
+
+void AodvStatsRx(uint32_t nodeId, Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  AodvNodeStats &st = g_aodvStats[nodeId];
+  Ipv4Header ip;
+  if (interface == 0) {
+    // Packets AODV loops back to itself while it searches for a route
+    if (p->PeekHeader(ip) && !ip.GetDestination().IsBroadcast() && !IsLocal(ipv4, ip.GetDestination())) {
+      st.deferred++;
+    }
+    return;
+  }
+  aodv::RreqHeader rreq;
+  if (!ParseRreq(p, ip, rreq)) return;
+  st.rreqRx++;
+  std::pair<uint32_t, uint32_t> key(rreq.GetOrigin().Get(), rreq.GetId());
+  auto it = st.rreqIdCache.find(key);
+  if (it == st.rreqIdCache.end() || it->second < Simulator::Now()) {
+    st.rreqIdCache[key] = Simulator::Now() + st.pathDiscoveryTime;
+  }
+}
+
+void AodvStatsTx(uint32_t nodeId, Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t)
+{
+  AodvNodeStats &st = g_aodvStats[nodeId];
+  Ipv4Header ip;
+  aodv::RreqHeader rreq;
+  if (!ParseRreq(p, ip, rreq)) return;
+  if (IsLocal(ipv4, rreq.GetOrigin())) {
+    st.rreqOriginated++;
+  } else {
+    st.rreqFwd++;
+  }
+}
+
+void AodvStatsForward(uint32_t nodeId, const Ipv4Header &ip, Ptr<const Packet>, uint32_t)
+{
+  AodvNodeStats &st = g_aodvStats[nodeId];
+  if (IsLocal(st.ipv4, ip.GetSource())) st.dequeued++;
+}
+
+void AodvStatsDrop(uint32_t nodeId, const Ipv4Header &ip, Ptr<const Packet>,
+                   Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t)
+{
+  if (reason == Ipv4L3Protocol::DROP_ROUTE_ERROR && IsLocal(ipv4, ip.GetSource())) {
+    g_aodvStats[nodeId].queueDrops++;
+  }
+}
+
+uint32_t CountRoutes(Ptr<aodv::RoutingProtocol> aodv)
+{
+  std::ostringstream oss;
+  aodv->PrintRoutingTable(Create<OutputStreamWrapper>(&oss));
+  std::istringstream lines(oss.str());
+  std::string line;
+  uint32_t routes = 0;
+  while (std::getline(lines, line)) {
+    if (!line.empty() && std::isdigit(static_cast<unsigned char>(line[0]))) routes++;
   }
+  return routes;
+}
+
+void SampleAodvStats(Time interval)
+{
+  Time now = Simulator::Now();
+  for (uint32_t n = 0; n < g_aodvStats.size(); ++n) {
+    AodvNodeStats &st = g_aodvStats[n];
+    for (auto it = st.rreqIdCache.begin(); it != st.rreqIdCache.end();) {
+      it = (it->second < now) ? st.rreqIdCache.erase(it) : std::next(it);
+    }
+    uint32_t routes = CountRoutes(st.aodv);
+    st.maxRoutes = std::max(st.maxRoutes, routes);
+    uint64_t gone = st.dequeued + st.queueDrops;
+    uint64_t queueLen = st.deferred > gone ? st.deferred - gone : 0;
+    st.maxIdCacheEst = std::max<uint64_t>(st.maxIdCacheEst, st.rreqIdCache.size());
+    st.maxQueueEst = std::max(st.maxQueueEst, queueLen);
+    g_aodvStatsFile << now.GetSeconds() << "," << n << "," << routes << ","
+                    << st.rreqIdCache.size() << "," << st.rreqRx << "," << st.rreqFwd << ","
+                    << (st.rreqRx > st.rreqFwd ? st.rreqRx - st.rreqFwd : 0) << ","
+                    << st.rreqOriginated << "," << queueLen << "," << st.queueDrops << "\n";
+  }
+  Simulator::Schedule(interval, &SampleAodvStats, interval);
+}
+
+void InstallAodvStats(NodeContainer nodes, const std::string &fileName, double interval)
+{
+  g_aodvStats.resize(nodes.GetN());
+  for (uint32_t n = 0; n < nodes.GetN(); ++n) {
+    AodvNodeStats &st = g_aodvStats[n];
+    st.ipv4 = nodes.Get(n)->GetObject<Ipv4>();
+    st.aodv = nodes.Get(n)->GetObject<aodv::RoutingProtocol>();
+    TimeValue pdt;
+    st.aodv->GetAttribute("PathDiscoveryTime", pdt);
+    st.pathDiscoveryTime = pdt.Get();
+
+    Ptr<Ipv4L3Protocol> l3 = nodes.Get(n)->GetObject<Ipv4L3Protocol>();
+    l3->TraceConnectWithoutContext("Rx", MakeBoundCallback(&AodvStatsRx, n));
+    l3->TraceConnectWithoutContext("Tx", MakeBoundCallback(&AodvStatsTx, n));
+    l3->TraceConnectWithoutContext("UnicastForward", MakeBoundCallback(&AodvStatsForward, n));
+    l3->TraceConnectWithoutContext("Drop", MakeBoundCallback(&AodvStatsDrop, n));
+  }
+  // rreq_suppressed: received but not rebroadcast (duplicate, TTL, rate limit or answered);
+  // est_*: mirrored from traces, not read from AODV
+  g_aodvStatsFile.open(fileName);
+  g_aodvStatsFile << "time,node,rt_entries,est_rreq_id_cache,rreq_rx,rreq_fwd,rreq_suppressed,"
+                  << "rreq_originated,est_queue_len,queue_drops\n";
+  Simulator::Schedule(Seconds(interval), &SampleAodvStats, Seconds(interval));
+}
+
+void PrintAodvStatsReport()
+{
+  std::set<uint32_t> attackers;
+  for (const BotnetMember &m : g_botnet) attackers.insert(m.node->GetId());
+  uint32_t peakLegit = 0, peakAttacker = 0;
+  uint64_t peakIdCache = 0, peakQueue = 0;
+  uint64_t rx = 0, fwd = 0, drops = 0;
+  for (uint32_t n = 0; n < g_aodvStats.size(); ++n) {
+    const AodvNodeStats &st = g_aodvStats[n];
+    if (attackers.count(n)) {
+      peakAttacker = std::max(peakAttacker, st.maxRoutes);
+    } else {
+      peakLegit = std::max(peakLegit, st.maxRoutes);
+      peakIdCache = std::max(peakIdCache, st.maxIdCacheEst);
+      peakQueue = std::max(peakQueue, st.maxQueueEst);
+    }
+    rx += st.rreqRx;
+    fwd += st.rreqFwd;
+    drops += st.queueDrops;
+  }
+  std::cout << "\n========== AODV Internals ==========" << std::endl;
+  std::cout << "Peak Routes (legit node):    " << peakLegit << " (parsed from PrintRoutingTable)" << std::endl;
+  std::cout << "Peak Routes (attackers):     " << peakAttacker << " (" << attackers.size() << " nodes)" << std::endl;
+  std::cout << "Peak RREQ-ID Cache (legit):  " << peakIdCache << " (estimate from traces)" << std::endl;
+  std::cout << "Peak Request Queue (legit):  " << peakQueue << " (estimate from traces)" << std::endl;
+  std::cout << "RREQs Received / Forwarded:  " << rx << " / " << fwd << std::endl;
+  std::cout << "Request Queue Drops:         " << drops << std::endl;
+  std::cout << "====================================" << std::endl;
+}
+
+// -------------------- Hardened AODV --------------------
+// aodv::RoutingProtocol with RREQ admission in front of it. The stock
+// routing table, RREQ-ID cache and rebroadcast path are private and cannot
+// be capped from a subclass, so only what is let in is controlled: each
+// originator gets a token bucket in a direct-mapped table, RREQs whose
+// originator or previous hop recently exchanged unicast traffic with this
+// node go straight to AODV, and RREQs from unknown originators wait in a
+// small FIFO served no faster than one per UnknownServiceInterval. A
+// collision overwrites the slot (eviction is O(1)) but the newcomer starts
+// on probation: one token, and its RREQ goes through the FIFO like an
+// unknown one, so cycling originators through a slot buys no fast path.
+// This bounds the rate at which reverse routes, cache entries and
+// rebroadcasts are created, not the table sizes: those still follow AODV's
+// own lifetimes, so an attacker that is admitted keeps its entries for
+// ActiveRouteTimeout / PathDiscoveryTime.
+class HardenedAodvRoutingProtocol : public aodv::RoutingProtocol
+{
+public:
+  struct Stats
+  {
+    uint64_t fastPath = 0;       // established originator or neighbour
+    uint64_t queued = 0;         // unknown originator, served from the FIFO
+    uint64_t rateDropped = 0;    // per-originator bucket empty
+    uint64_t queueDropped = 0;   // unknown FIFO full
+    uint64_t evictions = 0;      // originator slot taken over, newcomer queued
+    uint32_t maxQueue = 0;
+  };
+  static Stats s_stats;
+
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("HardenedAodvRoutingProtocol")
+      .SetParent<aodv::RoutingProtocol>()
+      .AddConstructor<HardenedAodvRoutingProtocol>()
+      .AddAttribute("OriginatorSlots", "Size of the per-originator RREQ bucket table",
+                    UintegerValue(64),
+                    MakeUintegerAccessor(&HardenedAodvRoutingProtocol::m_originatorSlots),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("OriginatorRreqRate", "RREQs per second accepted from one originator",
+                    DoubleValue(10.0),
+                    MakeDoubleAccessor(&HardenedAodvRoutingProtocol::m_originatorRate),
+                    MakeDoubleChecker<double>(0.0))
+      .AddAttribute("NeighbourSlots", "Size of the established-peer table",
+                    UintegerValue(32),
+                    MakeUintegerAccessor(&HardenedAodvRoutingProtocol::m_neighbourSlots),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("EstablishedTimeout", "How long unicast traffic keeps a peer established",
+                    TimeValue(Seconds(10.0)),
+                    MakeTimeAccessor(&HardenedAodvRoutingProtocol::m_establishedTimeout),
+                    MakeTimeChecker())
+      .AddAttribute("UnknownQueueLimit", "RREQs from unknown originators waiting for service",
+                    UintegerValue(8),
+                    MakeUintegerAccessor(&HardenedAodvRoutingProtocol::m_unknownLimit),
+                    MakeUintegerChecker<uint32_t>())
+      .AddAttribute("UnknownServiceInterval", "Pace at which unknown-originator RREQs are served",
+                    TimeValue(MilliSeconds(20)),
+                    MakeTimeAccessor(&HardenedAodvRoutingProtocol::m_unknownInterval),
+                    MakeTimeChecker());
+    return tid;
+  }
+
+  bool RouteInput(Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev,
+                  const UnicastForwardCallback &ucb, const MulticastForwardCallback &mcb,
+                  const LocalDeliverCallback &lcb, const ErrorCallback &ecb) override
+  {
+    aodv::RreqHeader rreq;
+    if (!ExtractRreq(p, header, rreq)) {
+      Ipv4Address dst = header.GetDestination();
+      if (!dst.IsBroadcast() && !dst.IsSubnetDirectedBroadcast(Ipv4Mask("255.255.255.0"))) {
+        Establish(header.GetSource()); // unicast traffic marks its source as a known peer
+      }
+      return aodv::RoutingProtocol::RouteInput(p, header, idev, ucb, mcb, lcb, ecb);
+    }
+
+    Admission admission = TakeToken(rreq.GetOrigin());
+    if (admission == ADMIT_NONE) {
+      s_stats.rateDropped++;
+      return true; // consumed: never reaches the routing table or rebroadcast
+    }
+    if (admission == ADMIT_TOKEN && (IsEstablished(rreq.GetOrigin()) || IsEstablished(header.GetSource()))) {
+      s_stats.fastPath++;
+      return aodv::RoutingProtocol::RouteInput(p, header, idev, ucb, mcb, lcb, ecb);
+    }
+    if (m_unknown.size() >= m_unknownLimit) {
+      s_stats.queueDropped++;
+      return true;
+    }
+    m_unknown.push_back({p, header, idev, ucb, mcb, lcb, ecb});
+    s_stats.queued++;
+    s_stats.maxQueue = std::max<uint32_t>(s_stats.maxQueue, m_unknown.size());
+    if (!m_serviceEvent.IsRunning()) {
+      // Paced from the last service, so a queue that keeps draining to
+      // empty is not served at the arrival rate
+      Time next = m_lastServe.IsNegative() ? Simulator::Now() : m_lastServe + m_unknownInterval;
+      m_serviceEvent = Simulator::Schedule(std::max(Time(), next - Simulator::Now()),
+                                           &HardenedAodvRoutingProtocol::ServeUnknown, this);
+    }
+    return true;
+  }
+
+protected:
+  void DoDispose(void) override
+  {
+    m_serviceEvent.Cancel();
+    m_unknown.clear();
+    aodv::RoutingProtocol::DoDispose();
+  }
+
+private:
+  enum Admission { ADMIT_NONE, ADMIT_TOKEN, ADMIT_PROBATION };
+
+  struct Bucket
+  {
+    uint32_t origin = 0;
+    double tokens = 0.0;
+    Time last;
+  };
+
+  struct Peer
+  {
+    uint32_t addr = 0;
+    Time lastSeen;
+  };
+
+  struct PendingRreq
+  {
+    Ptr<const Packet> packet;
+    Ipv4Header header;
+    Ptr<const NetDevice> idev;
+    UnicastForwardCallback ucb;
+    MulticastForwardCallback mcb;
+    LocalDeliverCallback lcb;
+    ErrorCallback ecb;
+  };
+
+  static uint32_t Slot(uint32_t addr, uint32_t slots)
+  {
+    return (addr * 2654435761u) % slots;
+  }
+
+  static bool ExtractRreq(Ptr<const Packet> p, const Ipv4Header &header, aodv::RreqHeader &rreq)
+  {
+    if (header.GetProtocol() != UdpL4Protocol::PROT_NUMBER) return false;
+    Ptr<Packet> copy = p->Copy();
+    UdpHeader udp;
+    aodv::TypeHeader type;
+    if (!copy->RemoveHeader(udp) || udp.GetDestinationPort() != AODV_PORT
+        || !copy->RemoveHeader(type) || !type.IsValid() || type.Get() != aodv::AODVTYPE_RREQ) {
+      return false;
+    }
+    return copy->RemoveHeader(rreq) > 0;
+  }
+
+  // An originator that takes over an occupied slot gets a single token and
+  // is admitted on probation
+  Admission TakeToken(Ipv4Address origin)
+  {
+    if (m_buckets.empty()) m_buckets.resize(m_originatorSlots);
+    Bucket &b = m_buckets[Slot(origin.Get(), m_originatorSlots)];
+    double burst = std::max(1.0, m_originatorRate);
+    Time now = Simulator::Now();
+    if (b.origin != origin.Get()) {
+      bool evicted = b.origin != 0;
+      b.origin = origin.Get();
+      b.tokens = evicted ? 0.0 : burst - 1.0; // the probationary token is spent at once
+      b.last = now;
+      if (!evicted) return ADMIT_TOKEN;
+      s_stats.evictions++;
+      return ADMIT_PROBATION;
+    }
+    b.tokens = std::min(burst, b.tokens + m_originatorRate * (now - b.last).GetSeconds());
+    b.last = now;
+    if (b.tokens < 1.0) return ADMIT_NONE;
+    b.tokens -= 1.0;
+    return ADMIT_TOKEN;
+  }
+
+  void Establish(Ipv4Address addr)
+  {
+    if (m_peers.empty()) m_peers.resize(m_neighbourSlots);
+    Peer &peer = m_peers[Slot(addr.Get(), m_neighbourSlots)];
+    peer.addr = addr.Get();
+    peer.lastSeen = Simulator::Now();
+  }
+
+  bool IsEstablished(Ipv4Address addr) const
+  {
+    if (m_peers.empty()) return false;
+    const Peer &peer = m_peers[Slot(addr.Get(), m_neighbourSlots)];
+    return peer.addr == addr.Get() && Simulator::Now() - peer.lastSeen <= m_establishedTimeout;
+  }
+
+  void ServeUnknown()
+  {
+    if (m_unknown.empty()) return;
+    PendingRreq r = m_unknown.front();
+    m_unknown.pop_front();
+    m_lastServe = Simulator::Now();
+    aodv::RoutingProtocol::RouteInput(r.packet, r.header, r.idev, r.ucb, r.mcb, r.lcb, r.ecb);
+    if (!m_unknown.empty()) {
+      m_serviceEvent = Simulator::Schedule(m_unknownInterval,
+                                           &HardenedAodvRoutingProtocol::ServeUnknown, this);
+    }
+  }
+
+  uint32_t m_originatorSlots;
+  double m_originatorRate;
+  uint32_t m_neighbourSlots;
+  Time m_establishedTimeout;
+  uint32_t m_unknownLimit;
+  Time m_unknownInterval;
+  Time m_lastServe{Seconds(-1.0)};
+  std::vector<Bucket> m_buckets;
+  std::vector<Peer> m_peers;
+  std::deque<PendingRreq> m_unknown;
+  EventId m_serviceEvent;
+};
+
+HardenedAodvRoutingProtocol::Stats HardenedAodvRoutingProtocol::s_stats;
+NS_OBJECT_ENSURE_REGISTERED(HardenedAodvRoutingProtocol);
+
+// Routing helper that installs HardenedAodvRoutingProtocol. It is not an
+// AodvHelper: that class's Set() is not virtual and configures its own
+// private factory, so a subclass could not route calls through a base
+// reference to this one. The hardened TypeId inherits every stock AODV
+// attribute, so Set() takes both sets.
+class HardenedAodvHelper : public Ipv4RoutingHelper
+{
+public:
+  HardenedAodvHelper()
+  {
+    m_factory.SetTypeId(HardenedAodvRoutingProtocol::GetTypeId());
+  }
+
+  HardenedAodvHelper *Copy(void) const override
+  {
+    return new HardenedAodvHelper(*this);
+  }
+
+  Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const override
+  {
+    Ptr<HardenedAodvRoutingProtocol> agent = m_factory.Create<HardenedAodvRoutingProtocol>();
+    node->AggregateObject(agent);
+    return agent;
+  }
+
+  void Set(std::string name, const AttributeValue &value)
+  {
+    m_factory.Set(name, value);
+  }
+
+private:
+  ObjectFactory m_factory;
+};
+
+void PrintHardenedAodvReport()
+{
+  const HardenedAodvRoutingProtocol::Stats &s = HardenedAodvRoutingProtocol::s_stats;
+  std::cout << "\n========== Hardened AODV Report ==========" << std::endl;
+  std::cout << "RREQs Fast-Path (known):     " << s.fastPath << std::endl;
+  std::cout << "RREQs Queued (unknown):      " << s.queued << std::endl;
+  std::cout << "RREQs Rate-Dropped:          " << s.rateDropped << std::endl;
+  std::cout << "RREQs Queue-Full Dropped:    " << s.queueDropped << std::endl;
+  std::cout << "Originator Slot Evictions:   " << s.evictions << std::endl;
+  std::cout << "Peak Unknown Queue:          " << s.maxQueue << std::endl;
+  std::cout << "==========================================" << std::endl;
+}
+
+// Counters published by --telemetrySocket
+std::string TelemetrySnapshot()
+{
+  std::ostringstream oss;
+  oss << "sent=" << g_packetsSent << " recv=" << g_packetsReceived
+      << " flood=" << g_floodingPacketsSent << " rreqs=" << g_totalRreqsReceived
+      << " rreqs_dropped=" << g_rreqsDropped << " nodes=";
+  // node:tracked/flagged for every defended node
+  for (uint32_t i = 0; i + g_botnet.size() < g_defenseManagers.size(); ++i) {
+    oss << (i ? "," : "") << i << ":" << g_defenseManagers[i]->GetTrackedSources()
+        << "/" << g_defenseManagers[i]->GetFlaggedSources();
+  }
+  return oss.str();
 }
 
 // -------------------- Advanced FlooderApplication --------------------
@@ -114,10 +1105,11 @@ public:
   AdvancedFlooderApplication() : m_socket(0) {}
   virtual ~AdvancedFlooderApplication() {}
 
-  void Setup(double interval, uint32_t packetSize)
+  void Setup(double interval, uint32_t packetSize, uint32_t bot)
   {
     m_interval = interval;
     m_packetSize = packetSize;
+    m_bot = bot;
   }
 
 private:
@@ -161,6 +1153,7 @@ private:
       Ptr<Packet> pkt = Create<Packet>(m_packetSize);
       m_socket->SendTo(pkt, 0, InetSocketAddress(Ipv4Address(randIp), 9));
       g_floodingPacketsSent++;
+      RecordAttackPacket(m_bot);
       NS_LOG_INFO("Flooder sent burst packet " << g_floodingPacketsSent << " to " << Ipv4Address(randIp));
     }
     ScheduleSend();
@@ -170,28 +1163,265 @@ private:
   EventId m_event;
   double m_interval{0.005}; // 200 bursts/sec = 600 pkt/s
   uint32_t m_packetSize{512};
+  uint32_t m_bot{0};
+};
+
+// -------------------- Sybil burst application --------------------
+// Botnet Sybil member: bursts of spoofed one-hop UDP broadcasts handed
+// straight to the device, cycling round-robin through its identities.
+class SybilBurstApplication : public Application
+{
+public:
+  void Setup(Ptr<NetDevice> device, uint32_t bot, const std::vector<Ipv4Address> &ids, double interval)
+  {
+    m_device = device;
+    m_bot = bot;
+    m_interval = Seconds(interval);
+    for (const Ipv4Address &id : ids) {
+      m_frames.push_back(BuildBroadcastFrame(id, 128, 10)); // not the UdpServer port, so PDR stays clean
+    }
+  }
+
+private:
+  virtual void StartApplication() override
+  {
+    m_event = Simulator::ScheduleNow(&SybilBurstApplication::Send, this);
+  }
+
+  virtual void StopApplication() override
+  {
+    if (m_event.IsRunning()) {
+      Simulator::Cancel(m_event);
+    }
+  }
+
+  void Send()
+  {
+    for (int i = 0; i < 6 && !m_frames.empty(); ++i) { // burst of 6 packets
+      if (SendBroadcastFrame(m_device, m_frames[m_index++ % m_frames.size()], m_ipId)) {
+        g_sybilPacketsSent++;
+        RecordAttackPacket(m_bot);
+      }
+    }
+    m_event = Simulator::Schedule(m_interval, &SybilBurstApplication::Send, this);
+  }
+
+  Ptr<NetDevice> m_device;
+  uint32_t m_bot{0};
+  Time m_interval;
+  std::vector<std::vector<uint8_t>> m_frames;
+  uint16_t m_ipId{0};
+  uint32_t m_index{0};
+  EventId m_event;
 };
 
+// -------------------- Botnet report --------------------
+void PrintBotnetSummary(uint32_t defendedNodes)
+{
+  std::set<AdvancedDefenseManager *> managers;
+  uint64_t tracked = 0, flagged = 0;
+  for (uint32_t i = 0; i < defendedNodes; ++i) {
+    if (!managers.insert(PeekPointer(g_defenseManagers[i])).second) continue;
+    tracked += g_defenseManagers[i]->GetTrackedSources();
+    flagged += g_defenseManagers[i]->GetFlaggedSources();
+  }
+  PrintBotnetReport(tracked, flagged);
+}
+
+// -------------------- Detector benchmark --------------------
+// benchSources legitimate sources at legitRate plus one flooder at floodRate
+void RunFloodingBenchmark(uint32_t legitSources, double legitRate, double floodRate, double seconds, Time tick)
+{
+  BenchmarkArrivals arrivals;
+  for (uint32_t i = 0; i < legitSources; ++i) {
+    AddBenchmarkStream(arrivals, Ipv4Address(0x0a000001 + i), legitRate, double(i) / legitSources, seconds);
+  }
+  Ipv4Address flooder("10.0.0.254");
+  g_attackerAddresses.insert(flooder);
+  AddBenchmarkStream(arrivals, flooder, floodRate, 0.0, seconds);
+
+  std::ostringstream workload;
+  workload << legitSources << " sources at " << legitRate << " pkt/s, flooder at " << floodRate << " pkt/s, "
+           << seconds << " s";
+  RunDetectorBenchmark<AdvancedDefenseManager>(
+      arrivals, workload.str(), tick,
+      [](AdvancedDefenseManager &m, Ipv4Address source, Time now) { m.ShouldAcceptRREQ(source, now); },
+      [](AdvancedDefenseManager &m, Ipv4Address source, Time now) { m.EnqueueRREQ(source, now); });
+}
+
 // -------------------- Main --------------------
 int main(int argc, char *argv[])
 {
   uint32_t numNodes = 15;
   double simTime = 30.0;
   bool enablePcap = true;
+  bool lean = false;
+  bool perfReport = false;
+  bool comparePerf = false;
+  uint32_t batchTickMs = 0;
+  bool benchDetector = false;
+  uint32_t benchSources = 50;
+  double benchSeconds = 60.0;
   bool enableDefense = true;
+  bool perNodeDefense = false;
+  bool enableGossip = false;
+  double gossipInterval = 0.5;
+  double gossipBatchDelay = 0.05;
+  uint32_t gossipTtl = 2;
+  bool enableCpuModel = false;
+  double rreqCostUs = 500.0;
+  double controlCostUs = 300.0;
+  double dataCostUs = 100.0;
+  double defenseCostUs = 20.0;
+  std::string aodvVariant = "stock";
+  uint32_t trafficFlows = 0;
+  std::string trafficPairs = "";
+  std::string trafficSource = "cbr";
+  double trafficRate = 10.0;
+  uint32_t trafficPacketSize = 512;
+  bool fairQueue = false;
+  uint32_t fqMaxPackets = 100;
+  uint32_t fqQuantum = 600;
+  uint32_t fqDeviceQueue = 10;
+  double floodRate = 600.0;
+  uint32_t numAttackers = 1;
+  std::string attackTypes = "flood";
+  std::string attackerPlacement = "mobile";
+  double attackStagger = 0.0;
+  uint32_t sybilIds = 6;
+  double sybilRate = 300.0;
+  bool realtime = false;
+  uint32_t rtDeadlineMs = 10;
+  bool convergence = false;
+  double convergenceBatch = 1.0;
+  double convergencePrecision = 0.05;
+  double convergenceMinTime = 10.0;
+  uint32_t convergenceMinBatches = 10;
+  std::string mobilityIn = "";
+  std::string mobilityOut = "";
+  double mobilityLookahead = 10.0;
+  std::string telemetrySocket = "";
+  uint32_t telemetryIntervalMs = 500;
+  bool enableEnergy = false;
+  double initialEnergyJ = 100.0;
+  double energyInterval = 1.0;
+  bool aodvStats = false;
+  double aodvStatsInterval = 1.0;
+  std::string aodvStatsFile = "flooding-defense-aodv.csv";
 
   CommandLine cmd;
   cmd.AddValue("enablePcap", "Enable PCAP tracing", enablePcap);
+  cmd.AddValue("lean", "Headless batch mode: no NetAnim, PCAP or logging, counters only", lean);
+  cmd.AddValue("perfReport", "Report run time and peak memory", perfReport);
+  cmd.AddValue("comparePerf", "Run full and then lean in child processes and print the ratios", comparePerf);
   cmd.AddValue("enableDefense", "Enable defense mechanism", enableDefense);
+  cmd.AddValue("detectionMode", "Detection: fixed (per-window limit) or ewma (learned baseline)", g_detectionMode);
+  cmd.AddValue("ewmaAlpha", "EWMA smoothing factor", g_ewmaAlpha);
+  cmd.AddValue("ewmaK", "Baseline deviations before a source is flagged", g_ewmaK);
+  cmd.AddValue("ewmaWarmup", "Seconds of baseline learning before verdicts", g_ewmaWarmup);
+  cmd.AddValue("batchTickMs", "Queue arrivals and judge them in batches every this many ms (0 = per packet)", batchTickMs);
+  cmd.AddValue("benchDetector", "Benchmark per-packet against batched decisions at floodRate and exit", benchDetector);
+  cmd.AddValue("benchSources", "Legitimate sources in the detector benchmark", benchSources);
+  cmd.AddValue("benchSeconds", "Seconds of arrivals in the detector benchmark", benchSeconds);
+  cmd.AddValue("perNodeDefense", "Give each node its own defense state instead of one shared view", perNodeDefense);
+  cmd.AddValue("enableGossip", "Broadcast blacklist digests to neighbours (implies perNodeDefense)", enableGossip);
+  cmd.AddValue("gossipInterval", "Minimum seconds between digests from one node", gossipInterval);
+  cmd.AddValue("gossipBatchDelay", "Seconds to batch new blacklist entries before sending", gossipBatchDelay);
+  cmd.AddValue("gossipTtl", "Hops a blacklist entry is re-gossiped", gossipTtl);
+  cmd.AddValue("gossipQuorum", "Distinct neighbour transmitters (MAC) needed before quarantining a source", g_gossipQuorum);
+  cmd.AddValue("enableCpuModel", "Model per-node packet processing capacity", enableCpuModel);
+  cmd.AddValue("cpuQueueLimit", "Packets the per-node service queue can hold", NodeCpuModel::s_queueLimit);
+  cmd.AddValue("rreqCostUs", "CPU cost per RREQ in microseconds", rreqCostUs);
+  cmd.AddValue("controlCostUs", "CPU cost per other AODV control packet in microseconds", controlCostUs);
+  cmd.AddValue("dataCostUs", "CPU cost per data packet in microseconds", dataCostUs);
+  cmd.AddValue("defenseCostUs", "CPU cost per defense decision in microseconds", defenseCostUs);
+  cmd.AddValue("trafficFlows", "Extra legitimate flows between random node pairs", trafficFlows);
+  cmd.AddValue("trafficPairs", "Extra flows between given pairs, e.g. 0-5,3-7 (overrides trafficFlows)", trafficPairs);
+  cmd.AddValue("trafficSource", "Extra flow source: cbr, poisson or onoff", trafficSource);
+  cmd.AddValue("trafficRate", "Packets per second per extra flow", trafficRate);
+  cmd.AddValue("trafficPacketSize", "Packet size in bytes for extra flows", trafficPacketSize);
+  cmd.AddValue("fairQueue", "Per-originator fair queueing of AODV control and data on normal nodes", fairQueue);
+  cmd.AddValue("fqMaxPackets", "Packets the fair queue holds across all flows", fqMaxPackets);
+  cmd.AddValue("fqQuantum", "Bytes each flow may send per round", fqQuantum);
+  cmd.AddValue("fqDeviceQueue", "Wi-Fi MAC queue size in packets when fair queueing is on", fqDeviceQueue);
+  cmd.AddValue("floodRate", "Attacker flood rate in packets per second", floodRate);
+  cmd.AddValue("numAttackers", "Number of attacker nodes added to the numNodes - 1 normal nodes", numAttackers);
+  cmd.AddValue("attackTypes", "Comma-separated attack types (flood, sybil) cycled over the attackers", attackTypes);
+  cmd.AddValue("attackerPlacement", "Attacker placement: mobile, uniform or clustered", attackerPlacement);
+  cmd.AddValue("attackStagger", "Seconds between the start times of successive attackers", attackStagger);
+  cmd.AddValue("sybilIds", "Spoofed identities per Sybil attacker", sybilIds);
+  cmd.AddValue("sybilRate", "Sybil attacker rate in packets per second", sybilRate);
+  cmd.AddValue("realtime", "Run under the real-time scheduler and report decision timing", realtime);
+  cmd.AddValue("rtDeadlineMs", "Lateness in ms after which a decision counts as a deadline miss", rtDeadlineMs);
+  cmd.AddValue("convergence", "Stop early once PDR and block rate have converged", convergence);
+  cmd.AddValue("convergenceBatch", "Seconds per batch for the batch-means estimate", convergenceBatch);
+  cmd.AddValue("convergencePrecision", "Relative 95% CI half-width at which a metric has converged", convergencePrecision);
+  cmd.AddValue("convergenceMinTime", "Earliest simulation time in seconds to stop at", convergenceMinTime);
+  cmd.AddValue("convergenceMinBatches", "Batches required per metric before stopping", convergenceMinBatches);
+  cmd.AddValue("mobilityIn", "Replay node movement from a binary waypoint trace", mobilityIn);
+  cmd.AddValue("mobilityOut", "Write the random-walk movement to a waypoint trace and exit", mobilityOut);
+  cmd.AddValue("mobilityLookahead", "Seconds of waypoints kept loaded when replaying", mobilityLookahead);
+  cmd.AddValue("telemetrySocket", "Unix datagram socket path for live counters (empty = off)", telemetrySocket);
+  cmd.AddValue("telemetryIntervalMs", "Wall-clock milliseconds between telemetry datagrams", telemetryIntervalMs);
+  cmd.AddValue("enableEnergy", "Install battery and Wi-Fi radio energy models", enableEnergy);
+  cmd.AddValue("initialEnergyJ", "Initial battery energy per node in joules", initialEnergyJ);
+  cmd.AddValue("energyInterval", "Seconds between residual energy samples", energyInterval);
+  cmd.AddValue("aodvVariant", "AODV implementation: stock or hardened", aodvVariant);
+  cmd.AddValue("aodvStats", "Sample AODV routing table, RREQ and queue state on every node", aodvStats);
+  cmd.AddValue("aodvStatsInterval", "Seconds between AODV samples", aodvStatsInterval);
+  cmd.AddValue("aodvStatsFile", "CSV file for AODV samples", aodvStatsFile);
   cmd.Parse(argc, argv);
 
-  LogComponentEnable("AdvancedFloodingDefenseSimulation", LOG_LEVEL_INFO);
+  if (benchDetector) {
+    RunFloodingBenchmark(benchSources, 10.0, floodRate, benchSeconds, MilliSeconds(std::max(batchTickMs, 1u)));
+    return 0;
+  }
+
+  if (comparePerf) {
+    perfReport = true;
+    if (!ForkPerfComparison(lean)) {
+      return 0;
+    }
+  }
 
-  g_defenseManager = CreateObject<AdvancedDefenseManager>();
+  g_batchTick = MilliSeconds(batchTickMs);
+  NS_ABORT_MSG_IF(batchTickMs > 0 && g_detectionMode != "fixed", "Batched evaluation supports the fixed detector only");
+  NS_ABORT_MSG_IF(batchTickMs > 0 && enableCpuModel, "The CPU model needs in-path verdicts; drop batchTickMs");
 
+  if (realtime) {
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::RealtimeSimulatorImpl"));
+    Config::SetDefault("ns3::RealtimeSimulatorImpl::SynchronizationMode", StringValue("BestEffort"));
+    g_realtime.enabled = true;
+    g_realtime.deadline = MilliSeconds(rtDeadlineMs);
+  }
+
+  if (lean) {
+    enablePcap = false;
+  } else {
+    LogComponentEnable("AdvancedFloodingDefenseSimulation", LOG_LEVEL_INFO);
+  }
+
+  perNodeDefense = perNodeDefense || enableGossip;
+
+  // Botnet composition: attack types are cycled over the attackers
+  std::vector<std::string> types;
+  std::istringstream typeList(attackTypes);
+  for (std::string type; std::getline(typeList, type, ',');) {
+    NS_ABORT_MSG_UNLESS(type == "flood" || type == "sybil", "Unknown attack type '" << type << "' (use flood or sybil)");
+    types.push_back(type);
+  }
+  NS_ABORT_MSG_IF(types.empty() || numAttackers == 0, "At least one attacker and attack type required");
+  NS_ABORT_MSG_UNLESS(attackerPlacement == "mobile" || attackerPlacement == "uniform"
+                      || attackerPlacement == "clustered",
+                      "Unknown attacker placement '" << attackerPlacement << "' (use mobile, uniform or clustered)");
+
+  uint32_t numNormal = numNodes - 1;
   NodeContainer nodes;
-  nodes.Create(numNodes);
-  Ptr<Node> attackerNode = nodes.Get(numNodes - 1);
+  nodes.Create(numNormal + numAttackers);
+  NodeContainer normalNodes, botNodes;
+  for (uint32_t i = 0; i < nodes.GetN(); ++i) {
+    (i < numNormal ? normalNodes : botNodes).Add(nodes.Get(i));
+  }
 
   // Wi-Fi setup
   WifiHelper wifi;
@@ -208,44 +1438,157 @@ int main(int argc, char *argv[])
   mac.SetType("ns3::AdhocWifiMac");
   NetDeviceContainer devices = wifi.Install(phy, mac, nodes);
 
-  // Mobility
-  MobilityHelper mobility;
-  mobility.SetPositionAllocator("ns3::GridPositionAllocator",
-    "MinX", DoubleValue(-200.0), "MinY", DoubleValue(-200.0),
-    "DeltaX", DoubleValue(50.0),  "DeltaY", DoubleValue(50.0),
-    "GridWidth", UintegerValue(4), "LayoutType", StringValue("RowFirst"));
-  mobility.SetMobilityModel("ns3::RandomWalk2dMobilityModel",
-    "Bounds", RectangleValue(Rectangle(-200, 200, -200, 200)),
-    "Speed", StringValue("ns3::UniformRandomVariable[Min=1.0|Max=3.0]"));
-  mobility.Install(nodes);
+  if (enableEnergy) {
+    InstallEnergy(nodes, devices, numNormal, initialEnergyJ, energyInterval,
+                  "flooding-defense-energy.csv");
+  }
+
+  // Mobility: random walk, or replayed from a trace file
+  if (!mobilityIn.empty()) {
+    NS_ABORT_MSG_UNLESS(g_mobilityReader.Open(mobilityIn, nodes, mobilityLookahead),
+                        "Cannot read mobility trace " << mobilityIn);
+    std::cout << "Mobility replayed from " << mobilityIn << std::endl;
+  } else {
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator("ns3::GridPositionAllocator",
+      "MinX", DoubleValue(-200.0), "MinY", DoubleValue(-200.0),
+      "DeltaX", DoubleValue(50.0),  "DeltaY", DoubleValue(50.0),
+      "GridWidth", UintegerValue(4), "LayoutType", StringValue("RowFirst"));
+    mobility.SetMobilityModel("ns3::RandomWalk2dMobilityModel",
+      "Bounds", RectangleValue(Rectangle(-200, 200, -200, 200)),
+      "Speed", StringValue("ns3::UniformRandomVariable[Min=1.0|Max=3.0]"));
+    if (attackerPlacement == "mobile") {
+      mobility.Install(nodes);
+    } else {
+      // Static attackers, spread over the area or packed around one corner
+      mobility.Install(normalNodes);
+      MobilityHelper fixed;
+      fixed.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+      fixed.Install(botNodes);
+      Ptr<UniformRandomVariable> pos = CreateObject<UniformRandomVariable>();
+      for (uint32_t b = 0; b < numAttackers; ++b) {
+        Vector at = attackerPlacement == "clustered"
+                    ? Vector(150.0 + pos->GetValue(-25.0, 25.0), 150.0 + pos->GetValue(-25.0, 25.0), 0.0)
+                    : Vector(pos->GetValue(-200.0, 200.0), pos->GetValue(-200.0, 200.0), 0.0);
+        botNodes.Get(b)->GetObject<MobilityModel>()->SetPosition(at);
+      }
+    }
+  }
+
+  // Trace generator: run the mobility alone for simTime and write it out
+  if (!mobilityOut.empty()) {
+    MobilityTraceWriter writer;
+    NS_ABORT_MSG_UNLESS(writer.Open(mobilityOut, nodes), "Cannot write mobility trace " << mobilityOut);
+    Simulator::Stop(Seconds(simTime));
+    Simulator::Run();
+    writer.Finish();
+    Simulator::Destroy();
+    std::cout << "Wrote " << writer.GetRecords() << " waypoints for " << nodes.GetN()
+              << " nodes to " << mobilityOut << std::endl;
+    return 0;
+  }
   
   
 
   // AODV with HELLO disabled to reduce overhead
   AodvHelper aodv;
   aodv.Set("EnableHello", BooleanValue(false));
+  HardenedAodvHelper hardenedAodv;
+  hardenedAodv.Set("EnableHello", BooleanValue(false));
   InternetStackHelper stack;
-  stack.SetRoutingHelper(aodv);
+  if (aodvVariant == "hardened") {
+    stack.SetRoutingHelper(hardenedAodv);
+    std::cout << "Hardened AODV ENABLED - bounded RREQ admission" << std::endl;
+  } else {
+    stack.SetRoutingHelper(aodv);
+  }
   stack.Install(nodes);
 
+  // Must precede address assignment, which installs the default root disc
+  if (fairQueue) {
+    TrafficControlHelper tch;
+    tch.SetRootQueueDisc("FairControlQueueDisc",
+                         "MaxSize", StringValue(std::to_string(fqMaxPackets) + "p"),
+                         "Quantum", UintegerValue(fqQuantum));
+    for (uint32_t i = 0; i < numNormal; ++i) {
+      tch.Install(devices.Get(i));
+      // Keep the MAC queue short so the backlog builds up where it is
+      // scheduled; attackers keep the default queue
+      PointerValue txop;
+      DynamicCast<WifiNetDevice>(devices.Get(i))->GetMac()->GetAttribute("Txop", txop);
+      txop.Get<Txop>()->GetWifiMacQueue()->SetMaxSize(QueueSize(std::to_string(fqDeviceQueue) + "p"));
+    }
+    std::cout << "Per-originator fair queueing ENABLED" << std::endl;
+  }
+
   // IP addressing
   Ipv4AddressHelper addr;
   addr.SetBase("10.0.0.0", "255.255.255.0");
   Ipv4InterfaceContainer interfaces = addr.Assign(devices);
+  // Ground truth: attacker IPs plus Sybil identities from 10.0.128.0 upwards
+  uint32_t nextIdentity = Ipv4Address("10.0.128.1").Get();
+  g_botnet.resize(numAttackers);
+  for (uint32_t b = 0; b < numAttackers; ++b) {
+    BotnetMember &member = g_botnet[b];
+    member.node = botNodes.Get(b);
+    member.type = types[b % types.size()];
+    member.start = Seconds(5.0 + b * attackStagger);
+    RegisterBotAddress(b, interfaces.GetAddress(numNormal + b));
+    for (uint32_t i = 0; member.type == "sybil" && i < sybilIds; ++i) {
+      RegisterBotAddress(b, Ipv4Address(nextIdentity++));
+    }
+  }
 
   // Defense trace on Rx for normal nodes
+  Ptr<AdvancedDefenseManager> sharedManager = CreateObject<AdvancedDefenseManager>();
+  g_defenseManagers.assign(nodes.GetN(), sharedManager);
   if (enableDefense) {
-    for (uint32_t i = 0; i < numNodes - 1; ++i) {
-      nodes.Get(i)->GetObject<Ipv4>()
-           ->TraceConnectWithoutContext("Rx", MakeCallback(&AdvancedAodvRxCallback));
+    for (uint32_t i = 0; i < numNormal; ++i) {
+      if (perNodeDefense) {
+        Ptr<AdvancedDefenseManager> manager = CreateObject<AdvancedDefenseManager>();
+        Ptr<BlacklistGossipApp> gossip;
+        if (enableGossip) {
+          gossip = CreateObject<BlacklistGossipApp>();
+          gossip->Setup(MakeBoundCallback(&QuarantineSource, manager),
+                        gossipInterval, gossipBatchDelay, gossipTtl);
+          nodes.Get(i)->AddApplication(gossip);
+          gossip->SetStartTime(Seconds(0.0));
+          gossip->SetStopTime(Seconds(simTime));
+        }
+        manager->SetBlacklistCallback(MakeBoundCallback(&OnLocalBlacklist, gossip));
+        g_defenseManagers[i] = manager;
+      }
+      if (!enableCpuModel) {
+        nodes.Get(i)->GetObject<Ipv4>()
+             ->TraceConnectWithoutContext("Rx", MakeCallback(&AdvancedAodvRxCallback));
+      }
     }
     std::cout << "Advanced Defense System ENABLED - Multi-layer protection active" << std::endl;
   } else {
     std::cout << "Defense System DISABLED - Network vulnerable" << std::endl;
   }
 
+  if (aodvStats) {
+    InstallAodvStats(nodes, aodvStatsFile, aodvStatsInterval);
+  }
+
+  // Processing model in front of the stack (and in-path defense) on normal nodes
+  if (enableCpuModel) {
+    NodeCpuModel::s_cost[NodeCpuModel::CLASS_RREQ] = MicroSeconds(rreqCostUs);
+    NodeCpuModel::s_cost[NodeCpuModel::CLASS_CONTROL] = MicroSeconds(controlCostUs);
+    NodeCpuModel::s_cost[NodeCpuModel::CLASS_DATA] = MicroSeconds(dataCostUs);
+    NodeCpuModel::s_defenseCost = MicroSeconds(defenseCostUs);
+    for (uint32_t i = 0; i < numNormal; ++i) {
+      Ptr<NodeCpuModel> cpu = CreateObject<NodeCpuModel>();
+      Ptr<AdvancedDefenseManager> inPath = enableDefense ? g_defenseManagers[i] : Ptr<AdvancedDefenseManager>();
+      cpu->Install(nodes.Get(i), devices.Get(i), inPath);
+      nodes.Get(i)->AggregateObject(cpu);
+    }
+    std::cout << "Node processing model ENABLED" << std::endl;
+  }
+
   // Legitimate traffic
-  uint32_t serverNodeId = numNodes - 2;
+  uint32_t serverNodeId = numNormal - 1;
   UdpServerHelper server(9);
   ApplicationContainer serverApps = server.Install(nodes.Get(serverNodeId));
   serverApps.Start(Seconds(1.0));
@@ -259,12 +1602,29 @@ int main(int argc, char *argv[])
   clientApps.Start(Seconds(2.0));
   clientApps.Stop(Seconds(simTime));
 
-  // Install the advanced flooder on the attacker
-  Ptr<AdvancedFlooderApplication> flooder = CreateObject<AdvancedFlooderApplication>();
-  flooder->Setup(0.005, 512);
-  attackerNode->AddApplication(flooder);
-  flooder->SetStartTime(Seconds(5.0));
-  flooder->SetStopTime(Seconds(simTime - 1.0));
+  if (trafficFlows > 0 || !trafficPairs.empty()) {
+    InstallTrafficMatrix(nodes, interfaces, numNormal, trafficFlows, trafficPairs, trafficSource,
+                         trafficRate, trafficPacketSize, 2.0, simTime);
+  }
+
+  // Install the attack applications, attacker b starting attackStagger after b - 1
+  for (uint32_t b = 0; b < numAttackers; ++b) {
+    const BotnetMember &member = g_botnet[b];
+    Ptr<Application> app;
+    if (member.type == "flood") {
+      Ptr<AdvancedFlooderApplication> flooder = CreateObject<AdvancedFlooderApplication>();
+      flooder->Setup(3.0 / floodRate, 512, b); // bursts of 3
+      app = flooder;
+    } else {
+      Ptr<SybilBurstApplication> sybil = CreateObject<SybilBurstApplication>();
+      std::vector<Ipv4Address> ids(member.addresses.begin() + 1, member.addresses.end());
+      sybil->Setup(devices.Get(numNormal + b), b, ids, 6.0 / sybilRate); // bursts of 6
+      app = sybil;
+    }
+    member.node->AddApplication(app);
+    app->SetStartTime(member.start);
+    app->SetStopTime(Seconds(simTime - 1.0));
+  }
 
   // Trace UDP application Tx/Rx
   clientApps.Get(0)->TraceConnectWithoutContext("Tx", MakeCallback(&TxCallback));
@@ -277,23 +1637,57 @@ int main(int argc, char *argv[])
   }
 
   
-  // NetAnim visualization
-  AnimationInterface anim("flooding-defence.xml");
-  for (uint32_t i = 0; i < numNodes - 1; ++i) {
-    anim.UpdateNodeColor(nodes.Get(i), 0, 255, 0);  // green normal
-    anim.UpdateNodeSize(nodes.Get(i)->GetId(), 10, 10);
+  // NetAnim visualization (it tags every packet, so not in lean mode)
+  std::unique_ptr<AnimationInterface> anim;
+  if (!lean) {
+    anim = std::make_unique<AnimationInterface>("flooding-defence.xml");
+    for (uint32_t i = 0; i < numNormal; ++i) {
+      anim->UpdateNodeColor(nodes.Get(i), 0, 255, 0);  // green normal
+      anim->UpdateNodeSize(nodes.Get(i)->GetId(), 10, 10);
+    }
+    for (uint32_t b = 0; b < numAttackers; ++b) {
+      anim->UpdateNodeColor(botNodes.Get(b), 255, 0, 0);  // red attacker
+      anim->UpdateNodeSize(botNodes.Get(b)->GetId(), 15, 15);
+    }
+  }
+
+  if (!telemetrySocket.empty() && !StartTelemetry(telemetrySocket, telemetryIntervalMs, &TelemetrySnapshot)) {
+    std::cout << "Telemetry disabled: cannot open socket for " << telemetrySocket << std::endl;
+  }
+
+  if (convergence) {
+    g_convergence.Setup(convergenceBatch, convergencePrecision, convergenceMinTime, convergenceMinBatches);
+    g_convergence.AddMetric("PDR", &g_packetsReceived, &g_packetsSent);
+    if (enableDefense) {
+      g_convergence.AddMetric("RREQ block rate", &g_rreqsDropped, &g_totalRreqsReceived);
+    }
+    // Batches begin with the earliest attacker
+    Time attackStart = Seconds(simTime);
+    for (const BotnetMember &m : g_botnet) {
+      attackStart = std::min(attackStart, m.start);
+    }
+    g_convergence.Start(attackStart);
   }
-  anim.UpdateNodeColor(attackerNode, 255, 0, 0);  // red attacker
-   anim.UpdateNodeSize(attackerNode->GetId(), 15, 15);  
 
   // Run simulation
+  if (realtime) Simulator::ScheduleNow(&StartRealtimeClock);
   Simulator::Stop(Seconds(simTime));
+  auto wallStart = std::chrono::steady_clock::now();
   Simulator::Run();
+  g_realtime.finish = std::chrono::steady_clock::now();
+  if (g_batchTick.IsStrictlyPositive()) {
+    for (auto &manager : g_defenseManagers) manager->FlushBatch(); // arrivals of the last tick
+  }
+  double wallSeconds = std::chrono::duration<double>(g_realtime.finish - wallStart).count();
+  double runTime = Simulator::Now().GetSeconds(); // shorter than simTime after an early stop
+  if (enableEnergy) FinalizeEnergy();
+  StopTelemetry();
+  anim.reset();
   Simulator::Destroy();
 
   // Results
   double pdr = (g_packetsSent > 0) ? (double)g_packetsReceived / g_packetsSent * 100.0 : 0.0;
-  double attackRate = g_floodingPacketsSent / simTime;
+  double attackRate = g_floodingPacketsSent / runTime;
   double defenseEffectiveness = (g_totalRreqsReceived > 0) ?
       ((double)g_rreqsDropped / g_totalRreqsReceived * 100.0) : 0.0;
   double networkResilience = (g_legitimateRreqs > 0) ?
@@ -301,6 +1695,12 @@ int main(int argc, char *argv[])
 
   std::cout << "\n========== RREQ Flooding Attack Defense Simulation Results ==========" << std::endl;
   std::cout << "Defense Status:              " << (enableDefense ? "ENABLED" : "DISABLED") << std::endl;
+  if (enableDefense && enableCpuModel) {
+    std::cout << "Defense Path:                in-path, rejected RREQs are dropped before AODV" << std::endl;
+  } else if (enableDefense) {
+    std::cout << "Defense Path:                observation only, verdicts are counted but nothing" << std::endl;
+    std::cout << "                             is dropped (not comparable with --enableCpuModel runs)" << std::endl;
+  }
   std::cout << "Legitimate Packets Sent:     " << g_packetsSent << std::endl;
   std::cout << "Legitimate Packets Received: " << g_packetsReceived << std::endl;
   std::cout << "Packet Delivery Ratio (%):   " << std::fixed << std::setprecision(2) << pdr << std::endl;
@@ -324,8 +1724,48 @@ int main(int argc, char *argv[])
   std::cout << "Network Security Status:     " << networkStatus << std::endl;
   std::cout << "============================================================" << std::endl;
 
+  if (enableCpuModel) {
+    PrintCpuReport(numNormal, runTime);
+  }
+  if (fairQueue) {
+    PrintFairQueueReport();
+  }
+  if (!g_flows.empty()) {
+    PrintTrafficReport(runTime - 2.0);
+  }
+  if (aodvVariant == "hardened") {
+    PrintHardenedAodvReport();
+  }
+  if (enableEnergy) {
+    DefensePath path = !enableDefense ? DEFENSE_OFF : (enableCpuModel ? DEFENSE_IN_PATH : DEFENSE_OBSERVE);
+    PrintEnergyReport(runTime, g_packetsReceived, path);
+  }
+  if (realtime) {
+    PrintRealtimeReport(numNormal);
+  }
+  if (convergence) {
+    g_convergence.PrintReport();
+  }
+  if (aodvStats) {
+    g_aodvStatsFile.close();
+    PrintAodvStatsReport();
+  }
+
   if (enableDefense) {
-    g_defenseManager->PrintSecurityReport();
+    if (perNodeDefense) {
+      for (uint32_t i = 0; i < numNormal; ++i) {
+        if (g_defenseManagers[i]->HasActivity()) {
+          g_defenseManagers[i]->PrintSecurityReport("(node " + std::to_string(i) + ") ");
+        }
+      }
+      PrintIsolationReport(numNormal);
+    } else {
+      sharedManager->PrintSecurityReport();
+    }
+    PrintDetectionAccuracy();
+    if (numAttackers > 1 || attackTypes != "flood") {
+      PrintBotnetSummary(numNormal);
+    }
     if (defenseEffectiveness > 50) {
       std::cout << "\nSUCCESS: Advanced defense system effectively mitigated the flooding attack!" << std::endl;
     } else if (defenseEffectiveness > 25) {
@@ -334,6 +1774,9 @@ int main(int argc, char *argv[])
       std::cout << "\nWARNING: Defense system needs improvement to handle this attack effectively." << std::endl;
     }
   }
+  if (lean || perfReport) {
+    PrintRunPerformance(lean, wallSeconds);
+  }
 
   return 0;
 }
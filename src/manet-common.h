@@ -0,0 +1,1759 @@
+#ifndef MANET_COMMON_H
+#define MANET_COMMON_H
+
+// Building blocks shared by the defense programs and the scenario engine:
+// adaptive thresholds, detection and botnet ground truth, raw broadcast
+// frames, batched windows, the detector cores, blacklist gossip, real-time
+// and energy accounting, live telemetry, early stopping, mobility traces
+// and the legitimate traffic matrix. Each program is a single translation
+// unit, so the globals below exist once per program.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/energy-module.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+// -------------------- Adaptive (EWMA) detection --------------------
+// "fixed" keeps the hard per-window limits; "ewma" learns a per-node baseline
+// of per-source window counts and flags sources that deviate from it.
+inline std::string g_detectionMode = "fixed";
+inline double g_ewmaAlpha = 0.1;    // smoothing factor for mean/variance
+inline double g_ewmaK = 4.0;        // deviations above the baseline before flagging
+inline double g_ewmaWarmup = 5.0;   // seconds of learning before any verdict
+
+// Exponentially weighted mean/variance, O(1) per sample
+struct EwmaStats
+{
+  double mean = 0.0;
+  double var = 0.0;
+  uint32_t samples = 0;
+
+  void Update(double x, double alpha)
+  {
+    if (samples++ == 0) {
+      mean = x;
+      return;
+    }
+    double diff = x - mean;
+    double incr = alpha * diff;
+    mean += incr;
+    var = (1.0 - alpha) * (var + diff * incr);
+  }
+
+  // Count threshold; variance is floored at the mean (Poisson noise)
+  double Limit(double k) const
+  {
+    return mean + k * std::sqrt(std::max(var, mean)) + 1.0;
+  }
+};
+
+// Per-source window counter feeding the node baseline
+struct SourceRate
+{
+  Time bucketStart;
+  uint32_t count = 0;
+  EwmaStats stats;
+};
+
+// Node baseline over per-source window counts; a source is over the limit
+// when its count in the current window exceeds the baseline by g_ewmaK
+// deviations. The caller passes whether the source is already flagged.
+class EwmaBaseline
+{
+public:
+  bool Accept(Ipv4Address source, Time now, double windowSeconds, bool flagged)
+  {
+    if (m_learnStart.IsNegative()) m_learnStart = now;
+    SourceRate &rate = m_rates[source];
+    if (rate.count == 0 || (now - rate.bucketStart).GetSeconds() >= windowSeconds) {
+      if (rate.count > 0) {
+        rate.stats.Update(rate.count, g_ewmaAlpha);
+        // Keep sources that are flagged or trending above the limit out of
+        // the baseline so a slow ramp cannot drag it upwards
+        bool trusted = !flagged && (m_baseline.samples == 0
+                                    || rate.stats.mean <= m_baseline.Limit(g_ewmaK));
+        if (trusted) {
+          m_baseline.Update(rate.count, g_ewmaAlpha);
+        }
+      }
+      rate.bucketStart = now;
+      rate.count = 0;
+    }
+    rate.count++;
+
+    if ((now - m_learnStart).GetSeconds() < g_ewmaWarmup || m_baseline.samples == 0) {
+      return true;
+    }
+    return rate.count <= m_baseline.Limit(g_ewmaK);
+  }
+
+  size_t Sources() const { return m_rates.size(); }
+
+private:
+  std::map<Ipv4Address, SourceRate> m_rates;
+  EwmaStats m_baseline; // all sources at this node
+  Time m_learnStart{Seconds(-1.0)};
+};
+
+// -------------------- Ground truth for accuracy --------------------
+// Attack applications register every address they send from; each
+// detector verdict is then scored against that set.
+inline std::set<Ipv4Address> g_attackerAddresses;
+inline std::set<Ipv4Address> g_legitSourcesSeen;
+inline std::set<Ipv4Address> g_legitSourcesFlagged;
+inline uint64_t g_legitDecisions = 0;
+inline uint64_t g_legitRejected = 0;
+inline uint64_t g_attackDecisions = 0;
+inline uint64_t g_attackRejected = 0;
+
+inline void RecordVerdict(Ipv4Address source, bool accepted)
+{
+  if (g_attackerAddresses.count(source)) {
+    g_attackDecisions++;
+    if (!accepted) g_attackRejected++;
+    return;
+  }
+  g_legitDecisions++;
+  g_legitSourcesSeen.insert(source);
+  if (!accepted) {
+    g_legitRejected++;
+    g_legitSourcesFlagged.insert(source);
+  }
+}
+
+inline void ResetVerdicts()
+{
+  g_attackerAddresses.clear();
+  g_legitSourcesSeen.clear();
+  g_legitSourcesFlagged.clear();
+  g_legitDecisions = g_legitRejected = g_attackDecisions = g_attackRejected = 0;
+}
+
+inline void PrintDetectionAccuracy()
+{
+  double pktFpr = g_legitDecisions ? 100.0 * g_legitRejected / g_legitDecisions : 0.0;
+  double srcFpr = g_legitSourcesSeen.empty() ? 0.0
+                  : 100.0 * g_legitSourcesFlagged.size() / g_legitSourcesSeen.size();
+  double tpr = g_attackDecisions ? 100.0 * g_attackRejected / g_attackDecisions : 0.0;
+  std::cout << "\n========== Detection Accuracy (" << g_detectionMode << ") ==========" << std::endl;
+  std::cout << "Attack Packets Blocked (%):  " << std::fixed << std::setprecision(2) << tpr << std::endl;
+  std::cout << "Legit Packet FPR (%):        " << pktFpr
+            << " (" << g_legitRejected << "/" << g_legitDecisions << ")" << std::endl;
+  std::cout << "Legit Source FPR (%):        " << srcFpr
+            << " (" << g_legitSourcesFlagged.size() << "/" << g_legitSourcesSeen.size() << ")" << std::endl;
+  std::cout << "===================================================" << std::endl;
+}
+
+// -------------------- Botnet ground truth --------------------
+// One entry per attacker node. Attack applications stamp the first packet
+// they send; detection is the first time any defended node flags one of
+// the attacker's addresses (own IP or Sybil identities).
+struct BotnetMember {
+  Ptr<Node> node;
+  std::string type;
+  Time start;
+  Time firstPacket{Seconds(-1.0)};
+  Time detected{Seconds(-1.0)};
+  std::vector<Ipv4Address> addresses;
+  uint32_t flagged = 0;
+  uint64_t sent = 0;
+};
+
+inline std::vector<BotnetMember> g_botnet;
+inline std::map<Ipv4Address, uint32_t> g_botnetOwner;
+inline std::set<Ipv4Address> g_botnetFlagged;
+inline uint32_t g_sybilPacketsSent = 0;
+
+inline void RegisterBotAddress(uint32_t bot, Ipv4Address address)
+{
+  g_botnet[bot].addresses.push_back(address);
+  g_botnetOwner[address] = bot;
+  g_attackerAddresses.insert(address);
+}
+
+inline void RecordAttackPacket(uint32_t bot)
+{
+  BotnetMember &member = g_botnet[bot];
+  if (member.firstPacket.IsNegative()) member.firstPacket = Simulator::Now();
+  member.sent++;
+}
+
+// Called whenever a detector flags a source
+inline void RecordDetection(Ipv4Address source)
+{
+  auto owner = g_botnetOwner.find(source);
+  if (owner == g_botnetOwner.end() || !g_botnetFlagged.insert(source).second) return;
+  BotnetMember &member = g_botnet[owner->second];
+  member.flagged++;
+  if (member.detected.IsNegative()) member.detected = Simulator::Now();
+}
+
+// `tracked` and `flagged` are summed over the distinct detectors by the caller
+inline void PrintBotnetReport(uint64_t tracked, uint64_t flagged)
+{
+  uint32_t detected = 0;
+  double latencySum = 0, latencyMax = 0;
+  std::cout << "\n========== Botnet Report (" << g_botnet.size() << " attackers) ==========" << std::endl;
+  std::cout << "  #  node  type   start(s)  sent      flagged  latency(s)" << std::endl;
+  for (uint32_t b = 0; b < g_botnet.size(); ++b) {
+    const BotnetMember &m = g_botnet[b];
+    std::cout << std::setw(3) << b << std::setw(6) << m.node->GetId() << "  " << std::setw(5) << std::left
+              << m.type << std::right << std::setw(10) << std::setprecision(2) << m.start.GetSeconds()
+              << std::setw(8) << m.sent << std::setw(7) << m.flagged << "/" << std::setw(2) << std::left
+              << m.addresses.size() << std::right;
+    if (!m.detected.IsNegative() && !m.firstPacket.IsNegative()) {
+      double latency = (m.detected - m.firstPacket).GetSeconds();
+      latencySum += latency;
+      latencyMax = std::max(latencyMax, latency);
+      detected++;
+      std::cout << std::setw(10) << std::setprecision(3) << latency << std::endl;
+    } else {
+      std::cout << "  undetected" << std::endl;
+    }
+  }
+  std::cout << "Attackers Detected:          " << detected << "/" << g_botnet.size() << std::endl;
+  std::cout << "Mean Detection Latency (s):  " << std::setprecision(3)
+            << (detected ? latencySum / detected : 0.0) << std::endl;
+  std::cout << "Max Detection Latency (s):   " << latencyMax << std::endl;
+  std::cout << "Sybil Packets Generated:     " << g_sybilPacketsSent << std::endl;
+  std::cout << "Detector State (tracked/flagged sources): " << tracked << "/" << flagged << std::endl;
+  std::cout << "=====================================================" << std::endl;
+}
+
+// -------------------- Raw broadcast frames --------------------
+// Attackers that must control exactly what a detector counts put serialized
+// IPv4/UDP broadcasts (TTL 1) straight onto their Wi-Fi device: one send is
+// one packet at each neighbour, with no RREQ fan-out, ARP or forwarding in
+// between. Each send copies the frame into a new packet with its own IPv4
+// Identification, so receivers never drop one as a duplicate.
+inline Ptr<WifiNetDevice> FindWifiDevice(Ptr<Node> node)
+{
+  for (uint32_t i = 0; i < node->GetNDevices(); ++i) {
+    Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(node->GetDevice(i));
+    if (device) return device;
+  }
+  NS_ABORT_MSG("Node " << node->GetId() << " has no Wi-Fi device");
+  return nullptr;
+}
+
+inline std::vector<uint8_t> BuildBroadcastFrame(Ipv4Address source, uint32_t payloadSize, uint16_t port)
+{
+  Ptr<Packet> packet = Create<Packet>(payloadSize);
+  UdpHeader udp;
+  udp.SetSourcePort(port);
+  udp.SetDestinationPort(port);
+  packet->AddHeader(udp);
+  Ipv4Header ip;
+  ip.SetSource(source);
+  ip.SetDestination(Ipv4Address("255.255.255.255"));
+  ip.SetProtocol(UdpL4Protocol::PROT_NUMBER);
+  ip.SetPayloadSize(packet->GetSize());
+  ip.SetTtl(1);
+  ip.SetDontFragment();
+  packet->AddHeader(ip);
+  std::vector<uint8_t> frame(packet->GetSize());
+  packet->CopyData(frame.data(), frame.size());
+  return frame;
+}
+
+// Packet for the next send of `frame`
+inline Ptr<Packet> NextBroadcastPacket(std::vector<uint8_t> &frame, uint16_t &ipId)
+{
+  frame[4] = static_cast<uint8_t>(ipId >> 8); // IPv4 Identification
+  frame[5] = static_cast<uint8_t>(ipId);
+  ipId++;
+  return Create<Packet>(frame.data(), frame.size());
+}
+
+// True once the device has queued the frame
+inline bool SendBroadcastFrame(Ptr<NetDevice> device, std::vector<uint8_t> &frame, uint16_t &ipId)
+{
+  return device->Send(NextBroadcastPacket(frame, ipId), device->GetBroadcast(), Ipv4L3Protocol::PROT_NUMBER);
+}
+
+// -------------------- Batched window evaluation --------------------
+// Optional fixed-mode path: arrivals are queued for g_batchTick and judged
+// together. State is kept as structure-of-arrays: sources are interned to
+// dense slots, and each slot holds its last `depth` accepted arrival times
+// in one contiguous block. That is all a "fewer than N in the window" test
+// needs, and counting it is a branch-free compare-and-add the compiler can
+// vectorize, instead of a pop_front walk through deque chunks. The
+// detectors own the rules; this only holds and counts the state.
+inline Time g_batchTick; // zero: judge every packet on arrival
+
+struct WindowBatch
+{
+  static constexpr int64_t kEmpty = std::numeric_limits<int64_t>::min();
+
+  uint32_t depth = 0;
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash> slotOf;
+  std::vector<Ipv4Address> address;  // per slot
+  std::vector<int64_t> history;      // depth arrival times (ns) per slot
+  std::vector<uint32_t> next;        // ring write position per slot
+  std::vector<uint8_t> blocked;      // per slot, source is flagged
+  std::vector<uint8_t> touched;      // per slot, history written this batch
+  std::vector<uint32_t> pendingSlot; // per queued arrival
+  std::vector<int64_t> pendingTime;  // per queued arrival
+  std::vector<uint32_t> counts;      // per queued arrival, first-pass counts
+
+  uint32_t Intern(Ipv4Address source)
+  {
+    auto it = slotOf.emplace(source, address.size());
+    if (it.second) {
+      address.push_back(source);
+      history.insert(history.end(), depth, kEmpty);
+      next.push_back(0);
+      blocked.push_back(0);
+      touched.push_back(0);
+    }
+    return it.first->second;
+  }
+
+  void Enqueue(Ipv4Address source, Time now)
+  {
+    pendingSlot.push_back(Intern(source));
+    pendingTime.push_back(now.GetNanoSeconds());
+  }
+
+  // Accepted arrivals of one slot at or after cutoff
+  uint32_t CountSince(uint32_t slot, int64_t cutoff) const
+  {
+    const int64_t *times = &history[size_t(slot) * depth];
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < depth; ++i) {
+      n += times[i] >= cutoff;
+    }
+    return n;
+  }
+
+  // First pass over the whole batch against the history as of the tick
+  // start; slots written during the batch are recounted by Count()
+  void CountAll(int64_t window)
+  {
+    counts.resize(pendingSlot.size());
+    for (size_t i = 0; i < pendingSlot.size(); ++i) {
+      counts[i] = CountSince(pendingSlot[i], pendingTime[i] - window);
+    }
+  }
+
+  uint32_t Count(size_t i, int64_t window) const
+  {
+    uint32_t slot = pendingSlot[i];
+    return touched[slot] ? CountSince(slot, pendingTime[i] - window) : counts[i];
+  }
+
+  // Overwrites the oldest entry, which is outside the window whenever the
+  // count was below depth
+  void Accept(size_t i)
+  {
+    uint32_t slot = pendingSlot[i];
+    history[size_t(slot) * depth + next[slot]] = pendingTime[i];
+    next[slot] = (next[slot] + 1) % depth;
+    touched[slot] = 1;
+  }
+
+  void Clear()
+  {
+    for (uint32_t slot : pendingSlot) touched[slot] = 0;
+    pendingSlot.clear();
+    pendingTime.clear();
+  }
+};
+
+// -------------------- Detector cores --------------------
+// The detection rules, shared by the defence programs and the scenario
+// engine's plug-ins. A core keeps the per-source state and returns a
+// verdict; counting, logging and acting on it are left to the caller.
+
+// Flooding detector: `limit` packets from one source inside `window` is
+// the most it accepts, every packet over that is a violation, and
+// `threshold` violations flag the source for good. "ewma" mode replaces
+// the fixed limit with the node baseline.
+class RateLimitCore
+{
+public:
+  enum Verdict { ACCEPT, OVER_LIMIT, FLAGGED };
+
+  uint32_t limit = 3;
+  Time window = Seconds(1.0);
+  uint32_t threshold = 10;
+  Callback<void, Ipv4Address> onFlagged; // once per source, at the threshold
+
+  Verdict Judge(Ipv4Address source, Time now)
+  {
+    if (IsFlagged(source)) return FLAGGED;
+
+    bool overLimit;
+    if (g_detectionMode == "ewma") {
+      overLimit = !m_ewma.Accept(source, now, window.GetSeconds(), m_violations.count(source) > 0);
+    } else {
+      auto &times = m_times[source];
+      while (!times.empty() && now - times.front() > window) {
+        times.pop_front();
+      }
+      overLimit = times.size() >= limit;
+      if (!overLimit) times.push_back(now);
+    }
+    if (!overLimit) return ACCEPT;
+    AddViolation(source);
+    return OVER_LIMIT;
+  }
+
+  // Batched mode: arrivals wait here until Flush
+  void Enqueue(Ipv4Address source, Time now) { Batch().Enqueue(source, now); }
+
+  // Judges the queued arrivals in order with the fixed-window rule and
+  // hands each verdict to onVerdict(source, verdict); returns the count
+  template <typename F>
+  size_t Flush(F onVerdict)
+  {
+    size_t arrivals = m_batch.pendingSlot.size();
+    int64_t windowNs = window.GetNanoSeconds();
+    m_batch.CountAll(windowNs);
+    for (size_t i = 0; i < arrivals; ++i) {
+      uint32_t slot = m_batch.pendingSlot[i];
+      Ipv4Address source = m_batch.address[slot];
+      Verdict verdict = FLAGGED;
+      if (!m_batch.blocked[slot]) {
+        if (m_batch.Count(i, windowNs) < limit) {
+          m_batch.Accept(i);
+          verdict = ACCEPT;
+        } else {
+          verdict = OVER_LIMIT;
+          if (AddViolation(source) >= threshold) m_batch.blocked[slot] = 1;
+        }
+      }
+      onVerdict(source, verdict);
+    }
+    m_batch.Clear();
+    return arrivals;
+  }
+
+  // Flags a source on a neighbour's report, without violations of its
+  // own; false if already flagged
+  bool Quarantine(Ipv4Address source)
+  {
+    if (IsFlagged(source)) return false;
+    m_quarantined.insert(source);
+    if (g_batchTick.IsStrictlyPositive()) Batch().blocked[Batch().Intern(source)] = 1;
+    return true;
+  }
+
+  bool IsFlagged(Ipv4Address source) const
+  {
+    return ViolationsOf(source) >= threshold || m_quarantined.count(source) > 0;
+  }
+
+  const std::map<Ipv4Address, uint32_t> &Violations() const { return m_violations; }
+  const std::set<Ipv4Address> &Quarantined() const { return m_quarantined; }
+
+  uint32_t ViolationsOf(Ipv4Address source) const
+  {
+    auto it = m_violations.find(source);
+    return it == m_violations.end() ? 0 : it->second;
+  }
+
+  bool HasActivity() const { return !m_violations.empty() || !m_quarantined.empty(); }
+
+  uint32_t TrackedSources() const
+  {
+    return std::max({m_times.size(), m_ewma.Sources(), m_batch.address.size()});
+  }
+
+  // Quarantined sources never collect violations, so the two do not overlap
+  uint32_t FlaggedSources() const
+  {
+    uint32_t flagged = m_quarantined.size();
+    for (auto &entry : m_violations) {
+      if (entry.second >= threshold) flagged++;
+    }
+    return flagged;
+  }
+
+private:
+  uint32_t AddViolation(Ipv4Address source)
+  {
+    uint32_t violations = ++m_violations[source];
+    if (violations == threshold && !onFlagged.IsNull()) onFlagged(source);
+    return violations;
+  }
+
+  WindowBatch &Batch()
+  {
+    if (m_batch.depth == 0) m_batch.depth = limit; // only the newest `limit` times matter
+    return m_batch;
+  }
+
+  std::map<Ipv4Address, std::deque<Time>> m_times;
+  std::map<Ipv4Address, uint32_t> m_violations;
+  std::set<Ipv4Address> m_quarantined; // flagged on a neighbour's report
+  EwmaBaseline m_ewma; // ewma mode
+  WindowBatch m_batch; // batched mode
+};
+
+// Sybil detector: `maxRate` packets from one source inside `window`, or
+// `burstSize` accepted ones inside `burstInterval`, is a violation, and
+// `blacklistThreshold` violations blacklist the source. "ewma" mode
+// replaces both tests with the node baseline.
+class SybilCore
+{
+public:
+  enum Verdict { ACCEPT, OVER_RATE, BURST, BASELINE, BLACKLISTED };
+
+  Time window = Seconds(5.0);
+  uint32_t maxRate = 3;
+  uint32_t burstSize = 5;
+  Time burstInterval = MilliSeconds(500);
+  uint32_t blacklistThreshold = 10;
+  Callback<void, Ipv4Address> onBlacklisted; // once per source, on its own violations
+
+  Verdict Judge(Ipv4Address source, Time now)
+  {
+    if (m_blacklist.count(source)) return BLACKLISTED;
+    Verdict verdict = Evaluate(source, now);
+    if (verdict != ACCEPT) Violation(source);
+    return verdict;
+  }
+
+  // Batched mode: arrivals wait here until Flush
+  void Enqueue(Ipv4Address source, Time now) { Batch().Enqueue(source, now); }
+
+  // Judges the queued arrivals in order with the same rate and burst rules
+  // as Judge and hands each verdict to onVerdict(source, verdict); returns
+  // the count
+  template <typename F>
+  size_t Flush(F onVerdict)
+  {
+    size_t arrivals = m_batch.pendingSlot.size();
+    int64_t windowNs = window.GetNanoSeconds();
+    int64_t burstSpan = burstInterval.GetNanoSeconds();
+    m_batch.CountAll(windowNs);
+    for (size_t i = 0; i < arrivals; ++i) {
+      uint32_t slot = m_batch.pendingSlot[i];
+      Ipv4Address source = m_batch.address[slot];
+      Verdict verdict;
+      if (m_batch.blocked[slot]) {
+        verdict = BLACKLISTED;
+      } else if (m_batch.Count(i, windowNs) >= maxRate) {
+        verdict = OVER_RATE;
+      } else {
+        m_batch.Accept(i);
+        // Strictly inside the burst span, as in Judge
+        bool burst = m_batch.CountSince(slot, m_batch.pendingTime[i] - burstSpan + 1) >= burstSize;
+        verdict = burst ? BURST : ACCEPT;
+      }
+      if (verdict == OVER_RATE || verdict == BURST) {
+        Violation(source);
+        if (m_blacklist.count(source)) m_batch.blocked[slot] = 1;
+      }
+      onVerdict(source, verdict);
+    }
+    m_batch.Clear();
+    return arrivals;
+  }
+
+  // Blacklists a source without local violations; false if already listed
+  bool Quarantine(Ipv4Address source)
+  {
+    if (!m_blacklist.insert(source).second) return false;
+    if (g_batchTick.IsStrictlyPositive()) Batch().blocked[Batch().Intern(source)] = 1;
+    return true;
+  }
+
+  const std::map<Ipv4Address, uint32_t> &Violations() const { return m_violations; }
+
+  uint32_t ViolationsOf(Ipv4Address source) const
+  {
+    auto it = m_violations.find(source);
+    return it == m_violations.end() ? 0 : it->second;
+  }
+
+  bool IsBlacklisted(Ipv4Address source) const { return m_blacklist.count(source) > 0; }
+
+  bool HasActivity() const { return !m_violations.empty() || !m_blacklist.empty(); }
+
+  uint32_t TrackedSources() const
+  {
+    return std::max({m_times.size(), m_ewma.Sources(), m_batch.address.size()});
+  }
+
+  uint32_t BlacklistedSources() const { return m_blacklist.size(); }
+
+private:
+  Verdict Evaluate(Ipv4Address source, Time now)
+  {
+    if (g_detectionMode == "ewma") {
+      bool flagged = m_violations.count(source) > 0;
+      return m_ewma.Accept(source, now, window.GetSeconds(), flagged) ? ACCEPT : BASELINE;
+    }
+
+    auto &times = m_times[source];
+    while (!times.empty() && now - times.front() > window) {
+      times.pop_front();
+    }
+    if (times.size() >= maxRate) return OVER_RATE;
+    times.push_back(now);
+    if (times.size() >= burstSize && now - times[times.size() - burstSize] < burstInterval) {
+      return BURST;
+    }
+    return ACCEPT;
+  }
+
+  void Violation(Ipv4Address source)
+  {
+    if (++m_violations[source] < blacklistThreshold || !m_blacklist.insert(source).second) return;
+    if (!onBlacklisted.IsNull()) onBlacklisted(source);
+  }
+
+  WindowBatch &Batch()
+  {
+    if (m_batch.depth == 0) { // the rate test needs the newest maxRate, the burst test burstSize
+      m_batch.depth = std::max(maxRate, burstSize);
+    }
+    return m_batch;
+  }
+
+  std::map<Ipv4Address, std::deque<Time>> m_times;
+  std::map<Ipv4Address, uint32_t> m_violations;
+  std::set<Ipv4Address> m_blacklist;
+  EwmaBaseline m_ewma; // ewma mode
+  WindowBatch m_batch; // batched mode
+};
+
+// -------------------- Blacklist gossip --------------------
+// Compact digest of blacklisted sources: addresses are sorted and each one is
+// sent as a varint delta from the previous, so clustered attacker ranges
+// (e.g. 10.0.0.200-205) cost about one byte per address.
+class BlacklistDigestHeader : public Header
+{
+public:
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("BlacklistDigestHeader")
+      .SetParent<Header>()
+      .AddConstructor<BlacklistDigestHeader>();
+    return tid;
+  }
+  TypeId GetInstanceTypeId(void) const override { return GetTypeId(); }
+
+  void SetTtl(uint8_t ttl) { m_ttl = ttl; }
+  uint8_t GetTtl(void) const { return m_ttl; }
+  void SetAddresses(const std::vector<uint32_t> &sorted) { m_addrs = sorted; }
+  const std::vector<uint32_t> &GetAddresses(void) const { return m_addrs; }
+
+  uint32_t GetSerializedSize(void) const override
+  {
+    uint32_t size = 2;
+    uint32_t prev = 0;
+    for (uint32_t a : m_addrs) {
+      size += VarintSize(a - prev);
+      prev = a;
+    }
+    return size;
+  }
+
+  void Serialize(Buffer::Iterator start) const override
+  {
+    start.WriteU8(m_ttl);
+    start.WriteU8(static_cast<uint8_t>(m_addrs.size()));
+    uint32_t prev = 0;
+    for (uint32_t a : m_addrs) {
+      uint32_t delta = a - prev;
+      while (delta >= 0x80) {
+        start.WriteU8(static_cast<uint8_t>(delta | 0x80));
+        delta >>= 7;
+      }
+      start.WriteU8(static_cast<uint8_t>(delta));
+      prev = a;
+    }
+  }
+
+  // Digests arrive from untrusted neighbours: a varint longer than five
+  // bytes or an address list that runs past the packet rejects the whole
+  // digest (returns 0, nothing consumed)
+  uint32_t Deserialize(Buffer::Iterator start) override
+  {
+    Buffer::Iterator i = start;
+    m_addrs.clear();
+    if (i.GetRemainingSize() < 2) return 0;
+    m_ttl = i.ReadU8();
+    uint8_t count = i.ReadU8();
+    uint32_t prev = 0;
+    for (uint8_t n = 0; n < count; ++n) {
+      uint32_t delta = 0;
+      uint8_t byte;
+      uint32_t len = 0;
+      do {
+        if (len == kMaxVarintBytes || i.GetRemainingSize() == 0) {
+          m_addrs.clear();
+          return 0;
+        }
+        byte = i.ReadU8();
+        delta |= uint32_t(byte & 0x7f) << (7 * len++);
+      } while (byte & 0x80);
+      prev += delta;
+      m_addrs.push_back(prev);
+    }
+    return i.GetDistanceFrom(start);
+  }
+
+  void Print(std::ostream &os) const override
+  {
+    os << "ttl=" << uint32_t(m_ttl) << " addrs=" << m_addrs.size();
+  }
+
+private:
+  static const uint32_t kMaxVarintBytes = 5; // 7 bits each covers 32
+
+  static uint32_t VarintSize(uint32_t v)
+  {
+    uint32_t n = 1;
+    while (v >= 0x80) { v >>= 7; n++; }
+    return n;
+  }
+
+  uint8_t m_ttl{1};
+  std::vector<uint32_t> m_addrs;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(BlacklistDigestHeader);
+
+const uint16_t g_gossipPort = 6543;
+inline uint32_t g_gossipDigestsSent = 0;
+inline uint32_t g_gossipBytesSent = 0;
+inline uint32_t g_gossipQuarantines = 0;
+inline uint32_t g_gossipQuorum = 2;        // distinct reporters needed before quarantining
+inline uint32_t g_gossipUncorroborated = 0; // reports still short of the quorum at the end
+inline uint32_t g_gossipUnattributed = 0;   // digests whose transmitter was not seen
+inline uint32_t g_gossipReportsDropped = 0; // reports for new addresses with the table full
+
+// Returns true for gossip digests so the detectors never rate-limit them
+inline bool IsGossipPacket(Ptr<const Packet> p)
+{
+  Ptr<Packet> copy = p->Copy();
+  Ipv4Header ip;
+  UdpHeader udp;
+  if (!copy->RemoveHeader(ip) || ip.GetProtocol() != UdpL4Protocol::PROT_NUMBER) return false;
+  return copy->PeekHeader(udp) && udp.GetDestinationPort() == g_gossipPort;
+}
+
+// BlacklistGossipApp: batches newly blacklisted sources and broadcasts them
+// to one-hop neighbours, at most one digest per m_minInterval. Received
+// addresses are handed to the local detector through m_quarantine once
+// g_gossipQuorum distinct reporters have named them; only addresses that
+// were new to this node are re-gossiped, with TTL - 1. A reporter is the
+// transmitter MAC of the digest, taken from a promiscuous IPv4 handler on
+// the node's Wi-Fi devices, so one radio sending from many spoofed IPs is
+// one reporter. Digests are not authenticated (see PrintIsolationReport
+// for the trust model).
+class BlacklistGossipApp : public Application
+{
+public:
+  typedef Callback<bool, Ipv4Address> QuarantineCallback;
+
+  void Setup(QuarantineCallback quarantine, double minInterval, double batchDelay, uint8_t ttl)
+  {
+    m_quarantine = quarantine;
+    m_minInterval = Seconds(minInterval);
+    m_batchDelay = Seconds(batchDelay);
+    m_ttl = ttl;
+  }
+
+  // A source was blacklisted locally
+  void Report(Ipv4Address source) { Enqueue(source.Get(), m_ttl); }
+
+private:
+  static const uint32_t kMaxAddrsPerDigest = 64;
+  static const uint32_t kMaxTransmitters = 64;     // digests awaiting their socket delivery
+  static const uint32_t kMaxPendingReports = 256;  // addresses short of the quorum
+
+  virtual void StartApplication() override
+  {
+    m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+    m_socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), g_gossipPort));
+    m_socket->SetAllowBroadcast(true);
+    m_socket->SetRecvCallback(MakeCallback(&BlacklistGossipApp::Receive, this));
+    for (uint32_t d = 0; d < GetNode()->GetNDevices(); ++d) {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(GetNode()->GetDevice(d));
+      if (device) {
+        GetNode()->RegisterProtocolHandler(MakeCallback(&BlacklistGossipApp::Sniff, this),
+                                           Ipv4L3Protocol::PROT_NUMBER, device, true);
+      }
+    }
+  }
+
+  virtual void StopApplication() override
+  {
+    g_gossipUncorroborated += m_reporters.size();
+    GetNode()->UnregisterProtocolHandler(MakeCallback(&BlacklistGossipApp::Sniff, this));
+    if (m_flushEvent.IsRunning()) Simulator::Cancel(m_flushEvent);
+    if (m_socket) {
+      m_socket->Close();
+      m_socket = nullptr;
+    }
+  }
+
+  void Enqueue(uint32_t addr, uint8_t ttl)
+  {
+    if (ttl == 0) return;
+    uint8_t &slot = m_pending[addr];
+    slot = std::max(slot, ttl);
+    if (!m_flushEvent.IsRunning()) {
+      Time at = std::max(Simulator::Now() + m_batchDelay, m_lastFlush + m_minInterval);
+      m_flushEvent = Simulator::Schedule(at - Simulator::Now(), &BlacklistGossipApp::Flush, this);
+    }
+  }
+
+  void Flush()
+  {
+    if (!m_socket || m_pending.empty()) return;
+    std::vector<uint32_t> addrs;
+    uint8_t ttl = 0;
+    auto it = m_pending.begin();
+    while (it != m_pending.end() && addrs.size() < kMaxAddrsPerDigest) {
+      addrs.push_back(it->first); // std::map keeps them sorted for delta coding
+      ttl = std::max(ttl, it->second);
+      it = m_pending.erase(it);
+    }
+
+    BlacklistDigestHeader digest;
+    digest.SetTtl(ttl);
+    digest.SetAddresses(addrs);
+    Ptr<Packet> pkt = Create<Packet>();
+    pkt->AddHeader(digest);
+    if (m_socket->SendTo(pkt, 0, InetSocketAddress(Ipv4Address("255.255.255.255"), g_gossipPort)) >= 0) {
+      g_gossipDigestsSent++;
+      g_gossipBytesSent += pkt->GetSize() + 8 + 20; // UDP + IPv4 headers
+    }
+    m_lastFlush = Simulator::Now();
+
+    if (!m_pending.empty()) {
+      m_flushEvent = Simulator::Schedule(m_minInterval, &BlacklistGossipApp::Flush, this);
+    }
+  }
+
+  // Remembers the transmitter of every digest this node hears. The device
+  // hands frames to the stack before the promiscuous handlers, so the
+  // socket's copy (same packet UID) is tallied in a later event.
+  void Sniff(Ptr<NetDevice>, Ptr<const Packet> p, uint16_t, const Address &from, const Address &,
+             NetDevice::PacketType)
+  {
+    if (!IsGossipPacket(p)) return;
+    if (m_transmitters.size() >= kMaxTransmitters) m_transmitters.erase(m_transmitters.begin());
+    m_transmitters[p->GetUid()] = Mac48Address::ConvertFrom(from);
+  }
+
+  void Receive(Ptr<Socket> socket)
+  {
+    Ptr<Packet> pkt;
+    Address from;
+    while ((pkt = socket->RecvFrom(from))) {
+      Simulator::ScheduleNow(&BlacklistGossipApp::Tally, this, pkt,
+                             InetSocketAddress::ConvertFrom(from).GetIpv4());
+    }
+  }
+
+  void Tally(Ptr<Packet> pkt, Ipv4Address sender)
+  {
+    auto tx = m_transmitters.find(pkt->GetUid());
+    if (tx == m_transmitters.end()) {
+      g_gossipUnattributed++;
+      return;
+    }
+    Mac48Address reporter = tx->second;
+    m_transmitters.erase(tx);
+    BlacklistDigestHeader digest;
+    if (pkt->RemoveHeader(digest) == 0) return;
+    for (uint32_t addr : digest.GetAddresses()) {
+      if (addr == sender.Get()) continue;
+      auto pending = m_reporters.find(addr);
+      if (pending == m_reporters.end()) {
+        if (m_reporters.size() >= kMaxPendingReports) {
+          g_gossipReportsDropped++;
+          continue;
+        }
+        pending = m_reporters.emplace(addr, std::set<Mac48Address>()).first;
+      }
+      std::set<Mac48Address> &reporters = pending->second;
+      reporters.insert(reporter);
+      if (reporters.size() < g_gossipQuorum) continue;
+      m_reporters.erase(addr);
+      if (m_quarantine(Ipv4Address(addr))) {
+        g_gossipQuarantines++;
+        Enqueue(addr, digest.GetTtl() - 1);
+      }
+    }
+  }
+
+  Ptr<Socket> m_socket;
+  QuarantineCallback m_quarantine;
+  std::map<uint32_t, uint8_t> m_pending;
+  std::map<uint32_t, std::set<Mac48Address>> m_reporters; // address -> distinct transmitters so far
+  std::map<uint64_t, Mac48Address> m_transmitters;         // digest packet UID -> transmitter
+  EventId m_flushEvent;
+  Time m_lastFlush{Seconds(-1000.0)};
+  Time m_minInterval{Seconds(0.5)};
+  Time m_batchDelay{MilliSeconds(50)};
+  uint8_t m_ttl{2};
+};
+
+// Network-wide isolation: when each source got blacklisted at each node
+struct IsolationRecord
+{
+  Time first;
+  Time last;
+  uint32_t nodes = 0;
+};
+inline std::map<Ipv4Address, IsolationRecord> g_isolation;
+
+inline void RecordIsolation(Ipv4Address source)
+{
+  IsolationRecord &rec = g_isolation[source];
+  if (rec.nodes == 0) rec.first = Simulator::Now();
+  rec.last = Simulator::Now();
+  rec.nodes++;
+}
+
+inline void PrintIsolationReport(uint32_t defendedNodes)
+{
+  std::cout << "\n========== Blacklist Gossip Report ==========" << std::endl;
+  std::cout << "Digests Sent:                " << g_gossipDigestsSent << std::endl;
+  std::cout << "Control Overhead (bytes):    " << g_gossipBytesSent << std::endl;
+  std::cout << "Pre-emptive Quarantines:     " << g_gossipQuarantines << std::endl;
+  std::cout << "Uncorroborated Reports:      " << g_gossipUncorroborated << std::endl;
+  std::cout << "Unattributed Digests:        " << g_gossipUnattributed << std::endl;
+  std::cout << "Reports Dropped (full):      " << g_gossipReportsDropped << std::endl;
+  std::cout << "Trust model: digests are unauthenticated and exempt from the detectors. A" << std::endl;
+  std::cout << "  neighbour report quarantines a source only after " << g_gossipQuorum
+            << " distinct transmitter" << (g_gossipQuorum == 1 ? "" : "s") << " name it." << std::endl;
+  std::cout << "  Reporters are told apart by transmitter MAC address, so spoofed source" << std::endl;
+  std::cout << "  IPs from one radio count once; an attacker that also forges MAC" << std::endl;
+  std::cout << "  addresses, or colluding nodes, can still reach the quorum." << std::endl;
+  for (auto &entry : g_isolation) {
+    const IsolationRecord &rec = entry.second;
+    std::cout << "  " << entry.first << " - isolated at " << rec.nodes << "/" << defendedNodes
+              << " nodes, first " << std::setprecision(3) << rec.first.GetSeconds() << "s"
+              << ", spread " << (rec.last - rec.first).GetSeconds() << "s"
+              << (rec.nodes >= defendedNodes ? " (network-wide)" : "") << std::endl;
+  }
+  std::cout << "=============================================" << std::endl;
+}
+
+inline void OnLocalBlacklist(Ptr<BlacklistGossipApp> gossip, Ipv4Address source)
+{
+  RecordIsolation(source);
+  if (gossip) gossip->Report(source);
+}
+
+// -------------------- Real-time mode --------------------
+// With --realtime the run is paced by RealtimeSimulatorImpl (best effort),
+// so the attack traffic reaches the nodes at its configured rate in wall-clock time.
+// Every defense decision records how late its event ran against the wall
+// clock and how long the verdict itself took; a decision that runs later
+// than the deadline counts as a miss. In batched mode the decisions are
+// made by the flush, whose time is split evenly over its arrivals.
+struct RealtimeMonitor {
+  static const uint32_t kBuckets = 7;
+  bool enabled = false;
+  Time deadline{MilliSeconds(10)};
+  std::chrono::steady_clock::time_point origin;
+  std::chrono::steady_clock::time_point finish;
+  uint64_t lateness[kBuckets] = {}; // <0.1 ms, <1 ms, <10 ms, <100 ms, <1 s, <10 s, more
+  uint64_t decisions = 0;
+  uint64_t misses = 0;
+  int64_t maxLatenessNs = 0;
+  int64_t decisionNs = 0;
+  int64_t maxDecisionNs = 0;
+};
+inline RealtimeMonitor g_realtime;
+
+inline void StartRealtimeClock() { g_realtime.origin = std::chrono::steady_clock::now(); }
+
+inline void RecordRealtimeDecision(std::chrono::steady_clock::time_point begin, uint64_t decisions = 1)
+{
+  if (decisions == 0) return;
+  auto end = std::chrono::steady_clock::now();
+  int64_t took = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  int64_t late = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - g_realtime.origin).count()
+                 - Simulator::Now().GetNanoSeconds();
+  late = std::max<int64_t>(late, 0);
+
+  uint32_t bucket = 0;
+  for (int64_t edge = 100000; bucket + 1 < RealtimeMonitor::kBuckets && late >= edge; edge *= 10) {
+    bucket++;
+  }
+  g_realtime.lateness[bucket] += decisions;
+  g_realtime.decisions += decisions;
+  if (late > g_realtime.deadline.GetNanoSeconds()) g_realtime.misses += decisions;
+  g_realtime.maxLatenessNs = std::max(g_realtime.maxLatenessNs, late);
+  g_realtime.decisionNs += took;
+  g_realtime.maxDecisionNs = std::max<int64_t>(g_realtime.maxDecisionNs, took / decisions);
+}
+
+// A batch flush decides `arrivals` verdicts at once
+inline void RecordRealtimeFlush(std::chrono::steady_clock::time_point begin, uint64_t arrivals)
+{
+  // The flush after the run is not paced by the simulator
+  if (g_realtime.enabled && !Simulator::IsFinished()) RecordRealtimeDecision(begin, arrivals);
+}
+
+inline void PrintRealtimeReport(uint32_t defendedNodes)
+{
+  static const char *labels[RealtimeMonitor::kBuckets] =
+      {"< 0.1 ms", "< 1 ms", "< 10 ms", "< 100 ms", "< 1 s", "< 10 s", ">= 10 s"};
+  double wall = std::chrono::duration<double>(g_realtime.finish - g_realtime.origin).count();
+  double meanUs = g_realtime.decisions ? g_realtime.decisionNs / 1000.0 / g_realtime.decisions : 0.0;
+  double perNode = (wall > 0 && defendedNodes > 0) ? g_realtime.decisions / wall / defendedNodes : 0.0;
+
+  std::cout << "\n========== Real-Time Execution Report ==========" << std::endl;
+  std::cout << "Wall-clock run time (s):     " << std::fixed << std::setprecision(2) << wall << std::endl;
+  std::cout << "Defense decisions:           " << g_realtime.decisions << std::endl;
+  std::cout << "Decisions/s per node (wall): " << std::setprecision(1) << perNode << std::endl;
+  std::cout << "Mean decision time (us):     " << std::setprecision(3) << meanUs << std::endl;
+  std::cout << "Max decision time (us):      " << g_realtime.maxDecisionNs / 1000.0 << std::endl;
+  std::cout << "Decision capacity (pkt/s):   " << std::setprecision(0)
+            << (meanUs > 0 ? 1e6 / meanUs : 0.0) << std::endl;
+  std::cout << "Max event lateness (ms):     " << std::setprecision(3) << g_realtime.maxLatenessNs / 1e6 << std::endl;
+  std::cout << "Deadline misses (> " << g_realtime.deadline.GetMilliSeconds() << " ms):   "
+            << g_realtime.misses << std::endl;
+  std::cout << "Event lateness histogram:" << std::endl;
+  for (uint32_t b = 0; b < RealtimeMonitor::kBuckets; ++b) {
+    std::cout << "  " << std::setw(9) << std::left << labels[b] << std::right << g_realtime.lateness[b] << std::endl;
+  }
+  std::cout << "Real-time verdict:           " << (g_realtime.misses == 0 ? "KEPT PACE" : "FELL BEHIND") << std::endl;
+  std::cout << "================================================" << std::endl;
+}
+
+// -------------------- Detector benchmark --------------------
+// Synthetic arrivals for --benchDetector as (time in ns, source)
+typedef std::vector<std::pair<int64_t, Ipv4Address>> BenchmarkArrivals;
+
+// Appends `source` sending at `rate` pkt/s for `seconds`, starting `phase` of a gap in
+inline void AddBenchmarkStream(BenchmarkArrivals &arrivals, Ipv4Address source, double rate, double phase,
+                               double seconds)
+{
+  int64_t end = Seconds(seconds).GetNanoSeconds();
+  int64_t gap = Seconds(1.0 / rate).GetNanoSeconds();
+  for (int64_t t = int64_t(gap * phase); t < end; t += gap) arrivals.emplace_back(t, source);
+}
+
+// Replays `arrivals` straight into fresh detectors, outside the simulator,
+// once through judge(detector, source, now) and once through enqueue() with
+// a FlushBatch() every `tick`. Reports wall-clock decisions per second for
+// both; accepted arrivals are read off the shared verdict counters.
+template <typename Detector, typename Judge, typename Enqueue>
+inline void RunDetectorBenchmark(BenchmarkArrivals arrivals, const std::string &workload, Time tick,
+                                 Judge judge, Enqueue enqueue)
+{
+  std::sort(arrivals.begin(), arrivals.end());
+  auto rejected = []() { return g_legitRejected + g_attackRejected; };
+
+  Ptr<Detector> scalar = CreateObject<Detector>();
+  uint64_t rejectedBefore = rejected();
+  auto begin = std::chrono::steady_clock::now();
+  for (auto &arrival : arrivals) {
+    judge(*scalar, arrival.second, NanoSeconds(arrival.first));
+  }
+  double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  uint64_t scalarAccepted = arrivals.size() - (rejected() - rejectedBefore);
+
+  Ptr<Detector> batched = CreateObject<Detector>();
+  int64_t tickNs = tick.GetNanoSeconds();
+  int64_t tickEnd = tickNs;
+  rejectedBefore = rejected();
+  begin = std::chrono::steady_clock::now();
+  for (auto &arrival : arrivals) {
+    if (arrival.first >= tickEnd) {
+      batched->FlushBatch();
+      tickEnd = (arrival.first / tickNs + 1) * tickNs;
+    }
+    enqueue(*batched, arrival.second, NanoSeconds(arrival.first));
+  }
+  batched->FlushBatch();
+  double batchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  uint64_t batchAccepted = arrivals.size() - (rejected() - rejectedBefore);
+
+  double n = arrivals.size();
+  std::cout << "\n========== Detector Benchmark ==========" << std::endl;
+  std::cout << "Arrivals:                    " << arrivals.size() << " (" << workload << ")" << std::endl;
+  std::cout << "Per-packet decisions/s:      " << std::fixed << std::setprecision(0) << n / scalarSeconds
+            << " (accepted " << scalarAccepted << ")" << std::endl;
+  std::cout << "Batched decisions/s:         " << n / batchSeconds
+            << " (accepted " << batchAccepted << ", tick " << tick.GetMilliSeconds() << " ms)" << std::endl;
+  std::cout << "Speedup:                     " << std::setprecision(2) << scalarSeconds / batchSeconds << "x" << std::endl;
+  std::cout << "========================================" << std::endl;
+}
+
+// -------------------- Energy accounting --------------------
+// Optional BasicEnergySource + WifiRadioEnergyModel on every node. Residual
+// energy is sampled periodically; a node's lifetime ends when it drops to
+// the source's low-battery threshold.
+struct EnergyTracker
+{
+  EnergySourceContainer sources;
+  std::vector<double> depletedAt; // seconds, < 0 while alive
+  std::vector<double> finalJ;     // residual energy when the run ended
+  uint32_t legitNodes = 0;        // nodes [0, legitNodes) are reported
+  double initialJ = 0.0;
+  double lowFraction = 0.1;
+  std::ofstream csv;
+};
+inline EnergyTracker g_energy;
+
+inline void SampleEnergy(Time interval)
+{
+  double now = Simulator::Now().GetSeconds();
+  for (uint32_t i = 0; i < g_energy.sources.GetN(); ++i) {
+    double remaining = g_energy.sources.Get(i)->GetRemainingEnergy();
+    g_energy.csv << now << "," << i << "," << remaining << "\n";
+    if (g_energy.depletedAt[i] < 0 && remaining <= g_energy.lowFraction * g_energy.initialJ) {
+      g_energy.depletedAt[i] = now;
+    }
+  }
+  Simulator::Schedule(interval, &SampleEnergy, interval);
+}
+
+inline void InstallEnergy(NodeContainer nodes, NetDeviceContainer devices, uint32_t legitNodes,
+                   double initialJ, double interval, const std::string &fileName)
+{
+  BasicEnergySourceHelper sourceHelper;
+  sourceHelper.Set("BasicEnergySourceInitialEnergyJ", DoubleValue(initialJ));
+  g_energy.sources = sourceHelper.Install(nodes);
+  WifiRadioEnergyModelHelper radioHelper;
+  radioHelper.Install(devices, g_energy.sources);
+
+  DoubleValue low;
+  g_energy.sources.Get(0)->GetAttribute("BasicEnergyLowBatteryThreshold", low);
+  g_energy.lowFraction = low.Get();
+  g_energy.initialJ = initialJ;
+  g_energy.legitNodes = legitNodes;
+  g_energy.depletedAt.assign(nodes.GetN(), -1.0);
+  g_energy.csv.open(fileName);
+  g_energy.csv << "time,node,remaining_j\n";
+  Simulator::Schedule(Seconds(interval), &SampleEnergy, Seconds(interval));
+}
+
+// Must run before Simulator::Destroy() disposes the sources
+inline void FinalizeEnergy()
+{
+  g_energy.finalJ.clear();
+  for (uint32_t i = 0; i < g_energy.sources.GetN(); ++i) {
+    g_energy.finalJ.push_back(g_energy.sources.Get(i)->GetRemainingEnergy());
+  }
+  g_energy.csv.close();
+}
+
+// Whether the defense in a run can change what the radios do
+enum DefensePath
+{
+  DEFENSE_OFF,
+  DEFENSE_OBSERVE, // verdicts are counted but no packet is dropped
+  DEFENSE_IN_PATH  // rejected packets are dropped
+};
+
+inline void PrintEnergyReport(double elapsed, uint32_t delivered, DefensePath defense)
+{
+  double consumed = 0.0;
+  double minRemaining = g_energy.initialJ;
+  double firstDeath = -1.0;
+  uint32_t depleted = 0;
+  for (uint32_t i = 0; i < g_energy.legitNodes; ++i) {
+    double remaining = g_energy.finalJ[i];
+    consumed += g_energy.initialJ - remaining;
+    minRemaining = std::min(minRemaining, remaining);
+    if (g_energy.depletedAt[i] >= 0) {
+      depleted++;
+      if (firstDeath < 0 || g_energy.depletedAt[i] < firstDeath) firstDeath = g_energy.depletedAt[i];
+    }
+  }
+  double avgPower = (elapsed > 0 && g_energy.legitNodes > 0)
+                    ? consumed / g_energy.legitNodes / elapsed : 0.0;
+  double usable = (1.0 - g_energy.lowFraction) * g_energy.initialJ;
+
+  std::cout << "\n========== Energy Report ==========" << std::endl;
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "Energy Consumed, legit (J):  " << consumed << std::endl;
+  std::cout << "Avg Power per Node (W):      " << avgPower << std::endl;
+  std::cout << "Min Residual Energy (J):     " << minRemaining << std::endl;
+  std::cout << "Nodes Depleted:              " << depleted << "/" << g_energy.legitNodes << std::endl;
+  if (firstDeath >= 0) {
+    std::cout << "Network Lifetime (s):        " << firstDeath << " (first node depleted)" << std::endl;
+  } else {
+    std::cout << "Projected Lifetime (s):      " << (avgPower > 0 ? usable / avgPower : 0.0)
+              << " (at average drain)" << std::endl;
+  }
+  std::cout << "Joules per Delivered Packet: " << (delivered ? consumed / delivered : 0.0) << std::endl;
+  static const char *paths[] = {"off", "observation only", "in-path"};
+  std::cout << "Defense:                     " << paths[defense] << std::endl;
+  if (defense == DEFENSE_OBSERVE) {
+    std::cout << "  The defense drops nothing in this run, so energy is the same as without it." << std::endl;
+    std::cout << "  A with/without-defense energy comparison needs an in-path defense." << std::endl;
+  }
+  std::cout << "===================================" << std::endl;
+}
+
+// -------------------- Live telemetry --------------------
+// Publishes the running counters as one text datagram per wall-clock
+// interval to a local Unix datagram socket, e.g. watch a run with
+//   socat -u UNIX-RECV:/tmp/manet.sock -
+// A timer thread owns the schedule, so publication keeps its wall-clock
+// pace however slowly simulated time advances. Counters are never read off
+// the simulation thread: each tick the timer posts a snapshot request with
+// ScheduleWithContext (safe from other threads), the simulation thread
+// takes the snapshot between two events and stores it under the lock, and
+// the timer sends the latest one. A datagram is therefore at most one
+// interval old, unless a single event runs longer than that. Sends never
+// block; without a listener datagrams are simply dropped.
+struct Telemetry
+{
+  int fd = -1;
+  sockaddr_un addr;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::milliseconds interval{500};
+  std::string (*snapshot)() = nullptr; // the program's counters as key=value pairs
+  std::thread timer;
+  std::mutex lock;              // guards the fields below
+  std::condition_variable wake;
+  bool stopping = false;
+  std::string latest;           // last snapshot taken on the simulation thread
+  uint64_t published = 0;
+  uint64_t failed = 0;
+};
+inline Telemetry g_telemetry;
+
+// Simulation thread
+inline void TakeTelemetrySnapshot()
+{
+  std::ostringstream snap;
+  snap << "sim=" << Simulator::Now().GetSeconds() << " " << g_telemetry.snapshot();
+  std::lock_guard<std::mutex> guard(g_telemetry.lock);
+  g_telemetry.latest = snap.str();
+}
+
+// Timer thread
+inline void RunTelemetryTimer()
+{
+  std::unique_lock<std::mutex> guard(g_telemetry.lock);
+  auto next = g_telemetry.start;
+  while (true) {
+    guard.unlock();
+    Simulator::ScheduleWithContext(Simulator::NO_CONTEXT, Time(0), &TakeTelemetrySnapshot);
+    guard.lock();
+    next += g_telemetry.interval;
+    if (g_telemetry.wake.wait_until(guard, next, [] { return g_telemetry.stopping; })) break;
+
+    std::ostringstream msg;
+    msg << "wall=" << std::chrono::duration<double>(next - g_telemetry.start).count() << " "
+        << g_telemetry.latest << "\n";
+    std::string line = msg.str();
+    ssize_t n = sendto(g_telemetry.fd, line.data(), line.size(), MSG_DONTWAIT,
+                       reinterpret_cast<const sockaddr *>(&g_telemetry.addr), sizeof(g_telemetry.addr));
+    if (n < 0) {
+      g_telemetry.failed++;
+    } else {
+      g_telemetry.published++;
+    }
+  }
+}
+
+inline bool StartTelemetry(const std::string &path, uint32_t intervalMs, std::string (*snapshot)())
+{
+  if (path.size() >= sizeof(g_telemetry.addr.sun_path)) return false;
+  g_telemetry.fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (g_telemetry.fd < 0) return false;
+  std::memset(&g_telemetry.addr, 0, sizeof(g_telemetry.addr));
+  g_telemetry.addr.sun_family = AF_UNIX;
+  std::strncpy(g_telemetry.addr.sun_path, path.c_str(), sizeof(g_telemetry.addr.sun_path) - 1);
+  g_telemetry.interval = std::chrono::milliseconds(std::max<uint32_t>(intervalMs, 1));
+  g_telemetry.snapshot = snapshot;
+  g_telemetry.latest = "sim=0";
+  g_telemetry.start = std::chrono::steady_clock::now();
+  g_telemetry.timer = std::thread(&RunTelemetryTimer);
+  return true;
+}
+
+// Call after Simulator::Run() and before Simulator::Destroy()
+inline void StopTelemetry()
+{
+  if (g_telemetry.fd < 0) return;
+  {
+    std::lock_guard<std::mutex> guard(g_telemetry.lock);
+    g_telemetry.stopping = true;
+  }
+  g_telemetry.wake.notify_all();
+  g_telemetry.timer.join();
+  close(g_telemetry.fd);
+  g_telemetry.fd = -1;
+  std::cout << "Telemetry datagrams published: " << g_telemetry.published
+            << " (undelivered: " << g_telemetry.failed << ")" << std::endl;
+}
+
+// -------------------- Convergence controller --------------------
+// Optional early stop. Once the attack is running, every batch contributes
+// one ratio of counter deltas per target metric; the run stops as soon as
+// each metric's batch-means 95% confidence interval is within the
+// requested relative precision and the minimum duration has passed.
+inline double StudentT95(uint32_t dof)
+{
+  static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+  return dof <= 30 ? table[std::max<uint32_t>(dof, 1) - 1] : 1.960;
+}
+
+struct ConvergenceMetric {
+  std::string name;
+  const uint32_t *num;
+  const uint32_t *den;
+  uint32_t lastNum;
+  uint32_t lastDen;
+  std::vector<double> batches;
+
+  double Mean() const
+  {
+    double sum = 0;
+    for (double b : batches) sum += b;
+    return batches.empty() ? 0.0 : sum / batches.size();
+  }
+
+  double HalfWidth() const
+  {
+    if (batches.size() < 2) return std::numeric_limits<double>::infinity();
+    double mean = Mean(), ss = 0;
+    for (double b : batches) ss += (b - mean) * (b - mean);
+    double sd = std::sqrt(ss / (batches.size() - 1));
+    return StudentT95(batches.size() - 1) * sd / std::sqrt(batches.size());
+  }
+};
+
+class ConvergenceController
+{
+public:
+  void Setup(double batch, double precision, double minTime, uint32_t minBatches)
+  {
+    m_enabled = true;
+    m_batch = Seconds(batch);
+    m_precision = precision;
+    m_minTime = Seconds(minTime);
+    m_minBatches = minBatches;
+  }
+
+  void AddMetric(const std::string &name, const uint32_t *num, const uint32_t *den)
+  {
+    m_metrics.push_back({name, num, den, 0, 0, {}});
+  }
+
+  void Start(Time attackStart)
+  {
+    Simulator::Schedule(attackStart, &ConvergenceController::Begin, this);
+  }
+
+  bool IsEnabled() const { return m_enabled; }
+  bool StoppedEarly() const { return !m_stopTime.IsZero(); }
+
+  void PrintReport() const
+  {
+    std::cout << "\n========== Convergence Report ==========" << std::endl;
+    if (StoppedEarly()) {
+      std::cout << "Stopped early at " << std::fixed << std::setprecision(2) << m_stopTime.GetSeconds()
+                << " s: all metrics within " << m_precision * 100 << "% relative precision" << std::endl;
+    } else {
+      std::cout << "Ran to the configured end: metrics did not converge" << std::endl;
+    }
+    for (const ConvergenceMetric &m : m_metrics) {
+      std::cout << "  " << std::setw(22) << std::left << m.name << std::right << std::setprecision(2)
+                << m.Mean() * 100 << " % +/- " << m.HalfWidth() * 100 << " (" << m.batches.size()
+                << " batches)" << std::endl;
+    }
+    std::cout << "========================================" << std::endl;
+  }
+
+private:
+  void Begin()
+  {
+    for (ConvergenceMetric &m : m_metrics) {
+      m.lastNum = *m.num;
+      m.lastDen = *m.den;
+    }
+    Simulator::Schedule(m_batch, &ConvergenceController::Sample, this);
+  }
+
+  void Sample()
+  {
+    bool converged = Simulator::Now() >= m_minTime;
+    for (ConvergenceMetric &m : m_metrics) {
+      uint32_t dn = *m.num - m.lastNum, dd = *m.den - m.lastDen;
+      m.lastNum = *m.num;
+      m.lastDen = *m.den;
+      if (dd > 0) m.batches.push_back(static_cast<double>(dn) / dd);
+      converged = converged && m.batches.size() >= m_minBatches
+                  && m.HalfWidth() <= m_precision * std::fabs(m.Mean());
+    }
+    if (converged) {
+      m_stopTime = Simulator::Now();
+      Simulator::Stop();
+      return;
+    }
+    Simulator::Schedule(m_batch, &ConvergenceController::Sample, this);
+  }
+
+  bool m_enabled{false};
+  Time m_batch;
+  double m_precision{0.05};
+  Time m_minTime;
+  uint32_t m_minBatches{10};
+  Time m_stopTime;
+  std::vector<ConvergenceMetric> m_metrics;
+};
+
+inline ConvergenceController g_convergence;
+
+// -------------------- Mobility trace files --------------------
+// Binary waypoint stream: a header ("MWPT", version, node count) followed
+// by time-ordered 24-byte (time, x, y, z, node) records in host byte order. Nodes
+// move linearly between two of their records, which is exact for
+// random-walk legs. The reader only keeps a lookahead window of waypoints
+// in memory and tops it up from a periodic event.
+struct MobilityRecord {
+  double time;
+  float x, y, z;
+  uint32_t node;
+};
+
+const char g_mobilityMagic[4] = {'M', 'W', 'P', 'T'};
+const uint32_t g_mobilityVersion = 1;
+
+class MobilityTraceWriter
+{
+public:
+  bool Open(const std::string &path, NodeContainer nodes)
+  {
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file) return false;
+    m_nodes = nodes;
+    m_lastTime.assign(nodes.GetN(), -1.0);
+    uint32_t count = nodes.GetN();
+    m_file.write(g_mobilityMagic, sizeof(g_mobilityMagic));
+    m_file.write(reinterpret_cast<const char *>(&g_mobilityVersion), sizeof(g_mobilityVersion));
+    m_file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    for (uint32_t i = 0; i < count; ++i) {
+      Ptr<MobilityModel> model = nodes.Get(i)->GetObject<MobilityModel>();
+      Write(i, model->GetPosition());
+      model->TraceConnectWithoutContext("CourseChange",
+                                        MakeCallback(&MobilityTraceWriter::CourseChanged, this));
+    }
+    return true;
+  }
+
+  // Closing waypoint for every node so the last leg is complete
+  void Finish()
+  {
+    for (uint32_t i = 0; i < m_nodes.GetN(); ++i) {
+      Write(i, m_nodes.Get(i)->GetObject<MobilityModel>()->GetPosition());
+    }
+    m_file.close();
+  }
+
+  uint64_t GetRecords() const { return m_records; }
+
+private:
+  void CourseChanged(Ptr<const MobilityModel> model)
+  {
+    Write(model->GetObject<Node>()->GetId(), model->GetPosition());
+  }
+
+  void Write(uint32_t node, const Vector &pos)
+  {
+    double now = Simulator::Now().GetSeconds();
+    if (node >= m_lastTime.size() || m_lastTime[node] == now) return;
+    m_lastTime[node] = now;
+    MobilityRecord rec = {now, static_cast<float>(pos.x), static_cast<float>(pos.y),
+                          static_cast<float>(pos.z), node};
+    m_file.write(reinterpret_cast<const char *>(&rec), sizeof(rec));
+    m_records++;
+  }
+
+  std::ofstream m_file;
+  NodeContainer m_nodes;
+  std::vector<double> m_lastTime;
+  uint64_t m_records{0};
+};
+
+class MobilityTraceReader
+{
+public:
+  // Installs WaypointMobilityModel on the nodes and preloads the first window
+  bool Open(const std::string &path, NodeContainer nodes, double lookahead)
+  {
+    m_file.open(path, std::ios::binary);
+    char magic[4];
+    uint32_t version = 0, count = 0;
+    m_file.read(magic, sizeof(magic));
+    m_file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    m_file.read(reinterpret_cast<char *>(&count), sizeof(count));
+    if (!m_file || !std::equal(magic, magic + 4, g_mobilityMagic) || version != g_mobilityVersion) {
+      return false;
+    }
+    NS_ABORT_MSG_IF(count != nodes.GetN(), "Mobility trace has " << count << " nodes, scenario has "
+                    << nodes.GetN());
+
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::WaypointMobilityModel", "LazyNotify", BooleanValue(true));
+    mobility.Install(nodes);
+    for (uint32_t i = 0; i < count; ++i) {
+      m_models.push_back(nodes.Get(i)->GetObject<WaypointMobilityModel>());
+    }
+    m_lookahead = Seconds(lookahead);
+    Next();
+    Refill();
+    return true;
+  }
+
+  uint64_t GetLoaded() const { return m_loaded; }
+
+private:
+  void Next()
+  {
+    m_file.read(reinterpret_cast<char *>(&m_pending), sizeof(m_pending));
+    m_hasPending = static_cast<bool>(m_file);
+  }
+
+  void Refill()
+  {
+    Time horizon = Simulator::Now() + m_lookahead;
+    while (m_hasPending && Seconds(m_pending.time) <= horizon) {
+      if (m_pending.node < m_models.size()) {
+        m_models[m_pending.node]->AddWaypoint(
+            Waypoint(Seconds(m_pending.time), Vector(m_pending.x, m_pending.y, m_pending.z)));
+        m_loaded++;
+      }
+      Next();
+    }
+    if (m_hasPending) {
+      Simulator::Schedule(m_lookahead / 2, &MobilityTraceReader::Refill, this);
+    }
+  }
+
+  std::ifstream m_file;
+  std::vector<Ptr<WaypointMobilityModel>> m_models;
+  MobilityRecord m_pending;
+  bool m_hasPending{false};
+  Time m_lookahead;
+  uint64_t m_loaded{0};
+};
+
+inline MobilityTraceReader g_mobilityReader;
+
+// -------------------- Traffic matrix --------------------
+// Optional extra legitimate load: N flows between node pairs, each a
+// TrafficFlowApp sending SeqTs-stamped UDP packets to a per-flow port on
+// the destination. Packets leave at a constant rate (cbr), with
+// exponential gaps of the same mean (poisson), or at the constant rate
+// during exponential on/off periods of 1 s mean (onoff).
+struct FlowStats {
+  uint32_t src = 0;
+  uint32_t dst = 0;
+  uint64_t sent = 0;
+  uint64_t received = 0;
+  uint64_t rxBytes = 0;
+  Time delaySum;
+  Time maxDelay;
+};
+
+inline std::vector<FlowStats> g_flows;
+const uint16_t g_flowBasePort = 20000;
+
+class TrafficFlowApp : public Application
+{
+public:
+  void Setup(uint32_t flow, Ipv4Address dst, const std::string &pattern, double rate, uint32_t packetSize)
+  {
+    m_flow = flow;
+    m_dst = dst;
+    m_pattern = pattern;
+    m_interval = Seconds(1.0 / rate);
+    m_packetSize = packetSize;
+  }
+
+private:
+  virtual void StartApplication() override
+  {
+    m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+    m_socket->Bind();
+    m_socket->Connect(InetSocketAddress(m_dst, g_flowBasePort + m_flow));
+    m_rng = CreateObject<ExponentialRandomVariable>();
+    m_on = true;
+    if (m_pattern == "onoff") {
+      m_toggleEvent = Simulator::Schedule(Seconds(m_rng->GetValue(1.0, 0)), &TrafficFlowApp::Toggle, this);
+    }
+    ScheduleNext();
+  }
+
+  virtual void StopApplication() override
+  {
+    Simulator::Cancel(m_sendEvent);
+    Simulator::Cancel(m_toggleEvent);
+    if (m_socket) {
+      m_socket->Close();
+      m_socket = 0;
+    }
+  }
+
+  void ScheduleNext()
+  {
+    Time gap = m_pattern == "poisson" ? Seconds(m_rng->GetValue(m_interval.GetSeconds(), 0)) : m_interval;
+    m_sendEvent = Simulator::Schedule(gap, &TrafficFlowApp::Send, this);
+  }
+
+  void Send()
+  {
+    SeqTsHeader hdr;
+    hdr.SetSeq(m_seq++);
+    uint32_t payload = m_packetSize > hdr.GetSerializedSize() ? m_packetSize - hdr.GetSerializedSize() : 0;
+    Ptr<Packet> p = Create<Packet>(payload);
+    p->AddHeader(hdr);
+    if (m_socket->Send(p) >= 0) g_flows[m_flow].sent++;
+    ScheduleNext();
+  }
+
+  void Toggle()
+  {
+    m_on = !m_on;
+    if (m_on) {
+      ScheduleNext();
+    } else {
+      Simulator::Cancel(m_sendEvent);
+    }
+    m_toggleEvent = Simulator::Schedule(Seconds(m_rng->GetValue(1.0, 0)), &TrafficFlowApp::Toggle, this);
+  }
+
+  Ptr<Socket> m_socket;
+  Ptr<ExponentialRandomVariable> m_rng;
+  EventId m_sendEvent;
+  EventId m_toggleEvent;
+  uint32_t m_flow{0};
+  Ipv4Address m_dst;
+  std::string m_pattern;
+  Time m_interval;
+  uint32_t m_packetSize{512};
+  uint32_t m_seq{0};
+  bool m_on{true};
+};
+
+inline void FlowSinkRx(uint32_t flow, Ptr<Socket> socket)
+{
+  FlowStats &stats = g_flows[flow];
+  while (Ptr<Packet> p = socket->Recv()) {
+    SeqTsHeader hdr;
+    stats.rxBytes += p->GetSize();
+    p->RemoveHeader(hdr);
+    Time delay = Simulator::Now() - hdr.GetTs();
+    stats.received++;
+    stats.delaySum += delay;
+    stats.maxDelay = std::max(stats.maxDelay, delay);
+  }
+}
+
+// Flows between "a-b,c-d" pairs, or numFlows random distinct pairs among
+// the first `candidates` nodes
+inline void InstallTrafficMatrix(NodeContainer nodes, Ipv4InterfaceContainer interfaces, uint32_t candidates,
+                          uint32_t numFlows, const std::string &pairs, const std::string &pattern,
+                          double rate, uint32_t packetSize, double start, double stop)
+{
+  NS_ABORT_MSG_UNLESS(pattern == "cbr" || pattern == "poisson" || pattern == "onoff",
+                      "Unknown traffic source '" << pattern << "' (use cbr, poisson or onoff)");
+  NS_ABORT_MSG_IF(candidates < 2, "Traffic matrix needs at least two nodes");
+  if (!pairs.empty()) {
+    std::istringstream list(pairs);
+    for (std::string pair; std::getline(list, pair, ',');) {
+      FlowStats flow;
+      char dash = 0;
+      std::istringstream fields(pair);
+      fields >> flow.src >> dash >> flow.dst;
+      NS_ABORT_MSG_IF(fields.fail() || dash != '-' || flow.src >= candidates || flow.dst >= candidates
+                      || flow.src == flow.dst, "Bad traffic pair '" << pair << "'");
+      g_flows.push_back(flow);
+    }
+  } else {
+    Ptr<UniformRandomVariable> pick = CreateObject<UniformRandomVariable>();
+    for (uint32_t i = 0; i < numFlows; ++i) {
+      FlowStats flow;
+      flow.src = pick->GetInteger(0, candidates - 1);
+      do {
+        flow.dst = pick->GetInteger(0, candidates - 1);
+      } while (flow.dst == flow.src);
+      g_flows.push_back(flow);
+    }
+  }
+
+  for (uint32_t f = 0; f < g_flows.size(); ++f) {
+    Ptr<Socket> sink = Socket::CreateSocket(nodes.Get(g_flows[f].dst), UdpSocketFactory::GetTypeId());
+    sink->Bind(InetSocketAddress(Ipv4Address::GetAny(), g_flowBasePort + f));
+    sink->SetRecvCallback(MakeBoundCallback(&FlowSinkRx, f));
+
+    Ptr<TrafficFlowApp> app = CreateObject<TrafficFlowApp>();
+    app->Setup(f, interfaces.GetAddress(g_flows[f].dst), pattern, rate, packetSize);
+    nodes.Get(g_flows[f].src)->AddApplication(app);
+    app->SetStartTime(Seconds(start + 0.01 * f)); // avoid synchronised first packets
+    app->SetStopTime(Seconds(stop));
+  }
+}
+
+inline void PrintTrafficReport(double duration)
+{
+  FlowStats total;
+  std::cout << "\n========== Traffic Matrix Report (" << g_flows.size() << " flows) ==========" << std::endl;
+  std::cout << " flow  src->dst    sent    recv   PDR(%)  kbit/s  avg/max delay (ms)" << std::endl;
+  for (uint32_t f = 0; f < g_flows.size(); ++f) {
+    const FlowStats &s = g_flows[f];
+    total.sent += s.sent;
+    total.received += s.received;
+    total.rxBytes += s.rxBytes;
+    total.delaySum += s.delaySum;
+    total.maxDelay = std::max(total.maxDelay, s.maxDelay);
+    std::cout << std::setw(5) << f << std::setw(5) << s.src << "->" << std::setw(3) << std::left << s.dst
+              << std::right << std::setw(8) << s.sent << std::setw(8) << s.received << std::fixed
+              << std::setprecision(2) << std::setw(9) << (s.sent ? 100.0 * s.received / s.sent : 0.0)
+              << std::setw(8) << s.rxBytes * 8 / duration / 1000.0 << "  " << std::setprecision(3)
+              << (s.received ? s.delaySum.GetSeconds() * 1000.0 / s.received : 0.0) << "/"
+              << s.maxDelay.GetSeconds() * 1000.0 << std::endl;
+  }
+  std::cout << "Aggregate PDR (%):           " << std::setprecision(2)
+            << (total.sent ? 100.0 * total.received / total.sent : 0.0) << std::endl;
+  std::cout << "Aggregate Goodput (kbit/s):  " << total.rxBytes * 8 / duration / 1000.0 << std::endl;
+  std::cout << "Mean/Max Latency (ms):       " << std::setprecision(3)
+            << (total.received ? total.delaySum.GetSeconds() * 1000.0 / total.received : 0.0) << "/"
+            << total.maxDelay.GetSeconds() * 1000.0 << std::endl;
+  std::cout << "=========================================================" << std::endl;
+}
+
+} // namespace ns3
+
+#endif // MANET_COMMON_H
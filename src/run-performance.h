@@ -0,0 +1,86 @@
+#ifndef RUN_PERFORMANCE_H
+#define RUN_PERFORMANCE_H
+
+#include "ns3/abort.h"
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Measurements of one run, reported by PrintRunPerformance
+struct RunPerformanceSample
+{
+  double wallSeconds = 0.0;
+  double peakRssMb = 0.0;
+};
+
+// Write end of the pipe to the --comparePerf parent, or -1
+inline int g_perfPipe = -1;
+
+// Wall-clock time of Simulator::Run and peak resident set size, so a --lean
+// batch run can be compared against a full instrumented one. In a
+// --comparePerf child the sample goes to the parent instead.
+inline void PrintRunPerformance(bool lean, double wallSeconds)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  RunPerformanceSample sample;
+  sample.wallSeconds = wallSeconds;
+  sample.peakRssMb = usage.ru_maxrss / 1024.0;
+  if (g_perfPipe >= 0) {
+    bool ok = write(g_perfPipe, &sample, sizeof(sample)) == sizeof(sample);
+    NS_ABORT_MSG_UNLESS(ok, "Cannot report run performance to the --comparePerf parent");
+    return;
+  }
+  std::cout << "\n========== Run Performance (" << (lean ? "lean" : "full") << ") ==========" << std::endl;
+  std::cout << "Wall-clock run time (s):     " << std::fixed << std::setprecision(3) << sample.wallSeconds << std::endl;
+  std::cout << "Peak RSS (MB):               " << std::setprecision(1) << sample.peakRssMb << std::endl;
+  std::cout << "=============================================" << std::endl;
+}
+
+// --comparePerf: runs the rest of main twice, full and then lean, each in a
+// forked child with its output discarded, and prints both samples and the
+// lean/full ratios. Returns true in a child, with lean set for that run, and
+// false in the parent once both runs are done.
+inline bool ForkPerfComparison(bool &lean)
+{
+  RunPerformanceSample samples[2];
+  for (int i = 0; i < 2; ++i) {
+    std::cout.flush();
+    int fds[2];
+    NS_ABORT_MSG_IF(pipe(fds) != 0, "pipe() failed");
+    pid_t pid = fork();
+    NS_ABORT_MSG_IF(pid < 0, "fork() failed");
+    if (pid == 0) {
+      close(fds[0]);
+      NS_ABORT_MSG_UNLESS(std::freopen("/dev/null", "w", stdout), "Cannot discard the output of a --comparePerf run");
+      g_perfPipe = fds[1];
+      lean = i == 1;
+      return true;
+    }
+    close(fds[1]);
+    int status;
+    waitpid(pid, &status, 0);
+    bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0
+              && read(fds[0], &samples[i], sizeof(samples[i])) == sizeof(samples[i]);
+    close(fds[0]);
+    NS_ABORT_MSG_UNLESS(ok, "The " << (i == 0 ? "full" : "lean") << " run failed");
+  }
+
+  const RunPerformanceSample &full = samples[0], &leanRun = samples[1];
+  std::cout << "\n========== Run Performance (full vs lean) ==========" << std::endl;
+  std::cout << "Wall-clock run time (s):     " << std::fixed << std::setprecision(3) << full.wallSeconds
+            << " / " << leanRun.wallSeconds << std::endl;
+  std::cout << "Peak RSS (MB):               " << std::setprecision(1) << full.peakRssMb
+            << " / " << leanRun.peakRssMb << std::endl;
+  std::cout << "Lean speedup:                " << std::setprecision(2)
+            << (leanRun.wallSeconds > 0 ? full.wallSeconds / leanRun.wallSeconds : 0.0) << "x" << std::endl;
+  std::cout << "Lean memory ratio:           "
+            << (full.peakRssMb > 0 ? leanRun.peakRssMb / full.peakRssMb : 0.0) << std::endl;
+  std::cout << "====================================================" << std::endl;
+  return false;
+}
+
+#endif // RUN_PERFORMANCE_H
@@ -0,0 +1,1586 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/aodv-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/netanim-module.h"
+#include "ns3/ipv4-raw-socket-factory.h"
+#include "manet-common.h"
+#include "run-performance.h"
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <deque>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <array>
+#include <cmath>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("ScenarioEngine");
+
+// One binary for every experiment: topology, traffic, attackers, detectors
+// and outputs come from a scenario file, and attack/defense plug-ins are
+// created by TypeId name, so a sweep is a directory of config files run
+// against the same build.
+
+// -------------------- Global counters --------------------
+uint32_t g_packetsSent = 0;
+uint32_t g_packetsReceived = 0;
+uint64_t g_bytesReceived = 0;
+uint64_t g_attackPacketsSent = 0;
+uint64_t g_defenseDrops = 0;
+
+void TxCallback(Ptr<const Packet>) { g_packetsSent++; }
+void RxCallback(Ptr<const Packet> p)
+{
+  g_packetsReceived++;
+  g_bytesReceived += p->GetSize();
+}
+
+// -------------------- Scenario file --------------------
+// INI-style: "[kind]" or "[kind name]" opens a section, "key = value" lines
+// fill it and '#' starts a comment. Every key must be consumed by the
+// engine or, in plug-in sections, name an attribute of the plug-in's TypeId,
+// so a typo aborts the run instead of silently using a default.
+struct ConfigSection {
+  std::string kind;
+  std::string name;
+  uint32_t line = 0;
+  std::map<std::string, std::string> values;
+  std::set<std::string> used;
+
+  std::string Label() const { return "[" + kind + (name.empty() ? "" : " " + name) + "]"; }
+
+  bool Has(const std::string &key) const { return values.count(key) > 0; }
+
+  std::string GetString(const std::string &key, const std::string &def)
+  {
+    auto it = values.find(key);
+    if (it == values.end()) return def;
+    used.insert(key);
+    return it->second;
+  }
+
+  double GetDouble(const std::string &key, double def)
+  {
+    if (!Has(key)) return def;
+    std::istringstream in(GetString(key, ""));
+    double value;
+    in >> value;
+    NS_ABORT_MSG_IF(in.fail() || !in.eof(), Label() << " " << key << ": expected a number");
+    return value;
+  }
+
+  uint32_t GetUint(const std::string &key, uint32_t def)
+  {
+    if (!Has(key)) return def;
+    double value = GetDouble(key, 0.0);
+    NS_ABORT_MSG_IF(value < 0 || value != (uint32_t)value, Label() << " " << key << ": expected a count");
+    return (uint32_t)value;
+  }
+
+  bool GetBool(const std::string &key, bool def)
+  {
+    if (!Has(key)) return def;
+    std::string value = GetString(key, "");
+    if (value == "true" || value == "1" || value == "yes") return true;
+    if (value == "false" || value == "0" || value == "no") return false;
+    NS_ABORT_MSG(Label() << " " << key << ": expected true or false");
+    return def;
+  }
+
+  // Comma-separated node indices with optional ranges: "0,3,5-7"
+  std::vector<uint32_t> GetNodeList(const std::string &key, uint32_t numNodes)
+  {
+    std::vector<uint32_t> list;
+    std::istringstream in(GetString(key, ""));
+    std::string item;
+    while (std::getline(in, item, ',')) {
+      uint32_t first = 0, last;
+      char dash;
+      std::istringstream range(item);
+      range >> first;
+      NS_ABORT_MSG_IF(range.fail(), Label() << " " << key << ": bad node '" << item << "'");
+      last = first;
+      if (range >> dash) {
+        NS_ABORT_MSG_UNLESS(dash == '-' && (range >> last), Label() << " " << key << ": bad node range '" << item << "'");
+      }
+      NS_ABORT_MSG_IF(range.fail() && !range.eof(), Label() << " " << key << ": bad node '" << item << "'");
+      NS_ABORT_MSG_IF(last < first || last >= numNodes,
+                      Label() << " " << key << ": node " << last << " outside 0-" << numNodes - 1);
+      for (uint32_t n = first; n <= last; ++n) list.push_back(n);
+    }
+    return list;
+  }
+
+  std::vector<std::pair<std::string, std::string>> Unused() const
+  {
+    std::vector<std::pair<std::string, std::string>> rest;
+    for (auto &kv : values) {
+      if (!used.count(kv.first)) rest.push_back(kv);
+    }
+    return rest;
+  }
+
+  void CheckAllUsed() const
+  {
+    for (auto &kv : Unused()) {
+      NS_ABORT_MSG(Label() << " line " << line << ": unknown key '" << kv.first << "'");
+    }
+  }
+};
+
+std::string Trim(const std::string &text)
+{
+  size_t begin = text.find_first_not_of(" \t\r");
+  if (begin == std::string::npos) return "";
+  size_t end = text.find_last_not_of(" \t\r");
+  return text.substr(begin, end - begin + 1);
+}
+
+std::vector<ConfigSection> ParseScenarioFile(const std::string &path)
+{
+  static const std::set<std::string> kinds = {"scenario", "wifi", "mobility", "aodv", "traffic",
+                                              "attack", "defense", "output"};
+  std::ifstream in(path);
+  NS_ABORT_MSG_UNLESS(in, "Cannot open scenario file " << path);
+
+  std::vector<ConfigSection> sections;
+  std::string raw;
+  uint32_t lineNo = 0;
+  while (std::getline(in, raw)) {
+    lineNo++;
+    std::string line = Trim(raw.substr(0, raw.find('#')));
+    if (line.empty()) continue;
+
+    if (line.front() == '[') {
+      NS_ABORT_MSG_UNLESS(line.back() == ']', path << ":" << lineNo << ": unterminated section header");
+      std::istringstream header(line.substr(1, line.size() - 2));
+      ConfigSection section;
+      header >> section.kind;
+      std::getline(header, section.name);
+      section.name = Trim(section.name);
+      section.line = lineNo;
+      NS_ABORT_MSG_UNLESS(kinds.count(section.kind), path << ":" << lineNo << ": unknown section '" << section.kind << "'");
+      sections.push_back(section);
+      continue;
+    }
+
+    size_t eq = line.find('=');
+    NS_ABORT_MSG_IF(eq == std::string::npos, path << ":" << lineNo << ": expected key = value");
+    NS_ABORT_MSG_IF(sections.empty(), path << ":" << lineNo << ": key outside any section");
+    std::string key = Trim(line.substr(0, eq));
+    NS_ABORT_MSG_UNLESS(sections.back().values.emplace(key, Trim(line.substr(eq + 1))).second,
+                        path << ":" << lineNo << ": duplicate key '" << key << "'");
+  }
+  return sections;
+}
+
+// The single instance of a section kind, or an empty one when absent
+ConfigSection &SingleSection(std::vector<ConfigSection> &sections, const std::string &kind)
+{
+  static std::map<std::string, ConfigSection> absent;
+  ConfigSection *found = nullptr;
+  for (auto &section : sections) {
+    if (section.kind != kind) continue;
+    NS_ABORT_MSG_IF(found, "Only one [" << kind << "] section allowed (line " << section.line << ")");
+    found = &section;
+  }
+  if (found) return *found;
+  absent[kind].kind = kind;
+  return absent[kind];
+}
+
+// -------------------- Plug-in registry --------------------
+// A section's "type" is a TypeId name, so any Application or DefensePlugin
+// compiled into the engine is available to configs; the aliases only keep
+// them readable. Remaining keys are set as attributes on the factory.
+struct PluginAlias {
+  const char *alias;
+  const char *typeName;
+};
+
+const PluginAlias g_pluginAliases[] = {
+  {"flooder", "FlooderApplication"},
+  {"sybil", "SybilNodeApp"},
+  {"sybil-burst", "SybilBurstApp"},
+  {"under-limit-flooder", "UnderLimitFlooderApplication"},
+  {"pulsed-flooder", "PulsedFlooderApplication"},
+  {"rotating-sybil", "RotatingSybilApp"},
+  {"rate-limit", "AdvancedDefenseManager"},
+  {"sybil-detector", "SybilDetector"},
+};
+
+ObjectFactory ConfigurePlugin(ConfigSection &section, TypeId base)
+{
+  std::string name = section.GetString("type", "");
+  NS_ABORT_MSG_IF(name.empty(), section.Label() << " line " << section.line << ": missing type");
+  for (auto &entry : g_pluginAliases) {
+    if (name == entry.alias) name = entry.typeName;
+  }
+
+  TypeId tid;
+  NS_ABORT_MSG_UNLESS(TypeId::LookupByNameFailSafe(name, &tid),
+                      section.Label() << ": unknown plug-in type '" << name << "'");
+  NS_ABORT_MSG_UNLESS(tid.IsChildOf(base) && tid.HasConstructor(),
+                      section.Label() << ": " << name << " is not a " << base.GetName() << " plug-in");
+
+  ObjectFactory factory;
+  factory.SetTypeId(tid);
+  for (auto &kv : section.Unused()) {
+    TypeId::AttributeInformation info;
+    NS_ABORT_MSG_UNLESS(tid.LookupAttributeByName(kv.first, &info),
+                        section.Label() << ": " << name << " has no attribute '" << kv.first << "'");
+    factory.Set(kv.first, StringValue(kv.second));
+    section.used.insert(kv.first);
+  }
+  return factory;
+}
+
+// -------------------- Attack frame accounting --------------------
+// Sends one attacker's raw broadcast frames and counts each in
+// g_attackPacketsSent when its PHY starts transmitting it, not when the MAC
+// queue accepts it: on a saturated channel queued broadcasts are dropped
+// and never reach a neighbour's detector. Broadcasts are not retried, so
+// the device's frames reach the PHY in send order and any still pending
+// ahead of the one on the air were dropped.
+class AttackFrameSender
+{
+public:
+  void Attach(Ptr<Node> node)
+  {
+    m_device = FindWifiDevice(node);
+    m_pending.clear();
+    if (!m_connected) {
+      m_device->GetPhy()->TraceConnectWithoutContext("PhyTxBegin",
+                                                     MakeCallback(&AttackFrameSender::TxBegin, this));
+      m_connected = true;
+    }
+  }
+
+  void Send(std::vector<uint8_t> &frame)
+  {
+    Ptr<Packet> packet = NextBroadcastPacket(frame, m_ipId);
+    if (m_device->Send(packet, m_device->GetBroadcast(), Ipv4L3Protocol::PROT_NUMBER)) {
+      m_pending.push_back(packet->GetUid());
+    }
+  }
+
+private:
+  void TxBegin(Ptr<const Packet> packet, double)
+  {
+    auto it = std::find(m_pending.begin(), m_pending.end(), packet->GetUid());
+    if (it == m_pending.end()) return; // not one of ours
+    m_pending.erase(m_pending.begin(), it + 1);
+    g_attackPacketsSent++;
+  }
+
+  Ptr<WifiNetDevice> m_device;
+  std::deque<uint64_t> m_pending; // queued at the MAC, in send order
+  uint16_t m_ipId = 0;
+  bool m_connected = false;
+};
+
+// -------------------- Attack plug-ins --------------------
+// FlooderApplication: bursts of UDP packets to random destinations, which
+// makes every neighbour's AODV broadcast an RREQ for each one
+class FlooderApplication : public Application
+{
+public:
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("FlooderApplication")
+      .SetParent<Application>()
+      .AddConstructor<FlooderApplication>()
+      .AddAttribute("Interval", "Time between bursts",
+                    TimeValue(MilliSeconds(5)),
+                    MakeTimeAccessor(&FlooderApplication::m_interval),
+                    MakeTimeChecker())
+      .AddAttribute("BurstSize", "Packets per burst",
+                    UintegerValue(3),
+                    MakeUintegerAccessor(&FlooderApplication::m_burstSize),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("PacketSize", "Payload bytes per packet",
+                    UintegerValue(512),
+                    MakeUintegerAccessor(&FlooderApplication::m_packetSize),
+                    MakeUintegerChecker<uint32_t>())
+      .AddAttribute("Port", "Destination UDP port",
+                    UintegerValue(9),
+                    MakeUintegerAccessor(&FlooderApplication::m_port),
+                    MakeUintegerChecker<uint16_t>());
+    return tid;
+  }
+
+  FlooderApplication() : m_rnd(CreateObject<UniformRandomVariable>()) {}
+
+private:
+  void StartApplication() override
+  {
+    NS_LOG_INFO("FlooderApplication starting on node " << GetNode()->GetId());
+    Ptr<Ipv4> ipv4 = GetNode()->GetObject<Ipv4>();
+    g_attackerAddresses.insert(ipv4->GetAddress(1, 0).GetLocal());
+    m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+    m_socket->Bind();
+    m_socket->SetAllowBroadcast(true);
+    m_event = Simulator::Schedule(m_interval, &FlooderApplication::Send, this);
+  }
+
+  void StopApplication() override
+  {
+    if (m_socket) {
+      m_socket->Close();
+      m_socket = nullptr;
+    }
+    Simulator::Cancel(m_event);
+  }
+
+  void Send()
+  {
+    for (uint32_t i = 0; i < m_burstSize; ++i) {
+      Ipv4Address dest(m_rnd->GetInteger(1, 0xfffffffe));
+      m_socket->SendTo(Create<Packet>(m_packetSize), 0, InetSocketAddress(dest, m_port));
+      g_attackPacketsSent++;
+    }
+    m_event = Simulator::Schedule(m_interval, &FlooderApplication::Send, this);
+  }
+
+  Ptr<UniformRandomVariable> m_rnd;
+  Ptr<Socket> m_socket;
+  EventId m_event;
+  Time m_interval;
+  uint32_t m_burstSize;
+  uint32_t m_packetSize;
+  uint16_t m_port;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(FlooderApplication);
+
+// SybilNodeApp: sends one spoofed raw broadcast frame per Interval from a
+// range of source addresses, one identity per packet in round-robin order
+class SybilNodeApp : public Application
+{
+public:
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("SybilNodeApp")
+      .SetParent<Application>()
+      .AddConstructor<SybilNodeApp>()
+      .AddAttribute("Identities", "Number of spoofed identities",
+                    UintegerValue(6),
+                    MakeUintegerAccessor(&SybilNodeApp::m_numIdentities),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("FirstIdentity", "Lowest spoofed source address",
+                    Ipv4AddressValue("10.0.0.200"),
+                    MakeIpv4AddressAccessor(&SybilNodeApp::m_firstIdentity),
+                    MakeIpv4AddressChecker())
+      .AddAttribute("Interval", "Time between packets",
+                    TimeValue(Seconds(0.8)),
+                    MakeTimeAccessor(&SybilNodeApp::m_interval),
+                    MakeTimeChecker())
+      .AddAttribute("PacketSize", "Payload bytes per packet",
+                    UintegerValue(128),
+                    MakeUintegerAccessor(&SybilNodeApp::m_packetSize),
+                    MakeUintegerChecker<uint32_t>());
+    return tid;
+  }
+
+private:
+  void StartApplication() override
+  {
+    m_sender.Attach(GetNode());
+    m_frames.clear();
+    for (uint32_t i = 0; i < m_numIdentities; ++i) {
+      Ipv4Address identity(m_firstIdentity.Get() + i);
+      g_attackerAddresses.insert(identity);
+      m_frames.push_back(BuildBroadcastFrame(identity, m_packetSize, 9));
+    }
+    m_event = Simulator::Schedule(Seconds(1.0), &SybilNodeApp::Send, this);
+  }
+
+  void StopApplication() override
+  {
+    Simulator::Cancel(m_event);
+  }
+
+  void Send()
+  {
+    m_sender.Send(m_frames[m_next]);
+    m_next = (m_next + 1) % m_frames.size();
+    m_event = Simulator::Schedule(m_interval, &SybilNodeApp::Send, this);
+  }
+
+  AttackFrameSender m_sender;
+  EventId m_event;
+  std::vector<std::vector<uint8_t>> m_frames;
+  uint32_t m_next = 0;
+  uint32_t m_numIdentities;
+  Ipv4Address m_firstIdentity;
+  Time m_interval;
+  uint32_t m_packetSize;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(SybilNodeApp);
+
+// SybilBurstApp: the attacker of src/sybil-defence.cc. Every BurstInterval
+// it sends BurstSize spoofed raw broadcast frames, identities in
+// round-robin order.
+class SybilBurstApp : public Application
+{
+public:
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("SybilBurstApp")
+      .SetParent<Application>()
+      .AddConstructor<SybilBurstApp>()
+      .AddAttribute("Identities", "Number of spoofed identities",
+                    UintegerValue(6),
+                    MakeUintegerAccessor(&SybilBurstApp::m_numIdentities),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("FirstIdentity", "Lowest spoofed source address",
+                    Ipv4AddressValue("10.0.0.200"),
+                    MakeIpv4AddressAccessor(&SybilBurstApp::m_firstIdentity),
+                    MakeIpv4AddressChecker())
+      .AddAttribute("BurstSize", "Packets per burst",
+                    UintegerValue(6),
+                    MakeUintegerAccessor(&SybilBurstApp::m_burstSize),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("BurstInterval", "Time between bursts",
+                    TimeValue(MilliSeconds(20)),
+                    MakeTimeAccessor(&SybilBurstApp::m_burstInterval),
+                    MakeTimeChecker())
+      .AddAttribute("PacketSize", "Payload bytes per packet",
+                    UintegerValue(128),
+                    MakeUintegerAccessor(&SybilBurstApp::m_packetSize),
+                    MakeUintegerChecker<uint32_t>());
+    return tid;
+  }
+
+private:
+  void StartApplication() override
+  {
+    m_sender.Attach(GetNode());
+    m_frames.clear();
+    for (uint32_t i = 0; i < m_numIdentities; ++i) {
+      Ipv4Address identity(m_firstIdentity.Get() + i);
+      g_attackerAddresses.insert(identity);
+      m_frames.push_back(BuildBroadcastFrame(identity, m_packetSize, 9));
+    }
+    m_event = Simulator::ScheduleNow(&SybilBurstApp::SendBurst, this);
+  }
+
+  void StopApplication() override
+  {
+    Simulator::Cancel(m_event);
+  }
+
+  void SendBurst()
+  {
+    for (uint32_t i = 0; i < m_burstSize; ++i) {
+      m_sender.Send(m_frames[m_next]);
+      m_next = (m_next + 1) % m_frames.size();
+    }
+    m_event = Simulator::Schedule(m_burstInterval, &SybilBurstApp::SendBurst, this);
+  }
+
+  AttackFrameSender m_sender;
+  EventId m_event;
+  std::vector<std::vector<uint8_t>> m_frames;
+  uint32_t m_next = 0;
+  uint32_t m_numIdentities;
+  Ipv4Address m_firstIdentity;
+  uint32_t m_burstSize;
+  Time m_burstInterval;
+  uint32_t m_packetSize;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(SybilBurstApp);
+
+// -------------------- Evasive attack plug-ins --------------------
+// Worst-case attackers for detector regressions. Each is shaped by the
+// thresholds of the detector it targets (set through its attributes), i.e.
+// the adversary is assumed to have already probed them: it sends as much
+// as it can without ever tripping the sliding-window test. They send raw
+// broadcast frames, so the pacing applies to exactly the packets a
+// per-node detector counts; UDP to random destinations would multiply
+// into RREQ retries and rebroadcasts the attacker does not pace.
+
+// UnderLimitFlooderApplication: Limit packets per Window, evenly spaced and
+// stretched by Margin, so at most Limit - 1 earlier packets are ever inside
+// the window
+class UnderLimitFlooderApplication : public Application
+{
+public:
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("UnderLimitFlooderApplication")
+      .SetParent<Application>()
+      .AddConstructor<UnderLimitFlooderApplication>()
+      .AddAttribute("Limit", "Packets per window the targeted detector accepts",
+                    UintegerValue(3),
+                    MakeUintegerAccessor(&UnderLimitFlooderApplication::m_limit),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("Window", "Window of the targeted detector",
+                    TimeValue(Seconds(1.0)),
+                    MakeTimeAccessor(&UnderLimitFlooderApplication::m_window),
+                    MakeTimeChecker())
+      .AddAttribute("Margin", "Fraction by which the spacing exceeds Window / Limit",
+                    DoubleValue(0.05),
+                    MakeDoubleAccessor(&UnderLimitFlooderApplication::m_margin),
+                    MakeDoubleChecker<double>(0.0))
+      .AddAttribute("PacketSize", "Payload bytes per packet",
+                    UintegerValue(512),
+                    MakeUintegerAccessor(&UnderLimitFlooderApplication::m_packetSize),
+                    MakeUintegerChecker<uint32_t>())
+      .AddAttribute("Port", "Destination UDP port (not the traffic port, so PDR stays clean)",
+                    UintegerValue(10),
+                    MakeUintegerAccessor(&UnderLimitFlooderApplication::m_port),
+                    MakeUintegerChecker<uint16_t>());
+    return tid;
+  }
+
+private:
+  void StartApplication() override
+  {
+    Ipv4Address self = GetNode()->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+    g_attackerAddresses.insert(self);
+    m_sender.Attach(GetNode());
+    m_frame = BuildBroadcastFrame(self, m_packetSize, m_port);
+    m_spacing = Seconds(m_window.GetSeconds() * (1.0 + m_margin) / m_limit);
+    m_event = Simulator::ScheduleNow(&UnderLimitFlooderApplication::Send, this);
+  }
+
+  void StopApplication() override
+  {
+    Simulator::Cancel(m_event);
+  }
+
+  void Send()
+  {
+    m_sender.Send(m_frame);
+    m_event = Simulator::Schedule(m_spacing, &UnderLimitFlooderApplication::Send, this);
+  }
+
+  AttackFrameSender m_sender;
+  std::vector<uint8_t> m_frame;
+  EventId m_event;
+  Time m_spacing;
+  uint32_t m_limit;
+  Time m_window;
+  double m_margin;
+  uint32_t m_packetSize;
+  uint16_t m_port;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(UnderLimitFlooderApplication);
+
+// PulsedFlooderApplication: on-off flood timed to the detector window. Each
+// pulse is PulseSize packets Spacing apart; the next pulse starts Guard after
+// the last packet of the previous one has left the Window. With PulseSize
+// at the detector's limit every pulse fits; above it, each pulse costs
+// PulseSize - limit violations and probes how fast the detector escalates.
+class PulsedFlooderApplication : public Application
+{
+public:
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("PulsedFlooderApplication")
+      .SetParent<Application>()
+      .AddConstructor<PulsedFlooderApplication>()
+      .AddAttribute("Window", "Window of the targeted detector",
+                    TimeValue(Seconds(1.0)),
+                    MakeTimeAccessor(&PulsedFlooderApplication::m_window),
+                    MakeTimeChecker())
+      .AddAttribute("PulseSize", "Packets per pulse",
+                    UintegerValue(3),
+                    MakeUintegerAccessor(&PulsedFlooderApplication::m_pulseSize),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("Spacing", "Gap between packets inside a pulse",
+                    TimeValue(MilliSeconds(1)),
+                    MakeTimeAccessor(&PulsedFlooderApplication::m_spacing),
+                    MakeTimeChecker())
+      .AddAttribute("Guard", "Extra quiet time after the window has cleared",
+                    TimeValue(MilliSeconds(5)),
+                    MakeTimeAccessor(&PulsedFlooderApplication::m_guard),
+                    MakeTimeChecker())
+      .AddAttribute("PacketSize", "Payload bytes per packet",
+                    UintegerValue(512),
+                    MakeUintegerAccessor(&PulsedFlooderApplication::m_packetSize),
+                    MakeUintegerChecker<uint32_t>())
+      .AddAttribute("Port", "Destination UDP port (not the traffic port, so PDR stays clean)",
+                    UintegerValue(10),
+                    MakeUintegerAccessor(&PulsedFlooderApplication::m_port),
+                    MakeUintegerChecker<uint16_t>());
+    return tid;
+  }
+
+private:
+  void StartApplication() override
+  {
+    Ipv4Address self = GetNode()->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+    g_attackerAddresses.insert(self);
+    m_sender.Attach(GetNode());
+    m_frame = BuildBroadcastFrame(self, m_packetSize, m_port);
+    m_sentInPulse = 0;
+    m_event = Simulator::ScheduleNow(&PulsedFlooderApplication::Send, this);
+  }
+
+  void StopApplication() override
+  {
+    Simulator::Cancel(m_event);
+  }
+
+  void Send()
+  {
+    m_sender.Send(m_frame);
+    if (++m_sentInPulse < m_pulseSize) {
+      m_event = Simulator::Schedule(m_spacing, &PulsedFlooderApplication::Send, this);
+      return;
+    }
+    m_sentInPulse = 0;
+    m_event = Simulator::Schedule(m_window + m_guard, &PulsedFlooderApplication::Send, this);
+  }
+
+  AttackFrameSender m_sender;
+  std::vector<uint8_t> m_frame;
+  EventId m_event;
+  uint32_t m_sentInPulse = 0;
+  Time m_window;
+  uint32_t m_pulseSize;
+  Time m_spacing;
+  Time m_guard;
+  uint32_t m_packetSize;
+  uint16_t m_port;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(PulsedFlooderApplication);
+
+// RotatingSybilApp: spreads its rate over many spoofed identities so that
+// each one sends at most MaxRate packets per Window. Identities are used
+// round-robin, which also keeps every identity far from burst thresholds.
+class RotatingSybilApp : public Application
+{
+public:
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("RotatingSybilApp")
+      .SetParent<Application>()
+      .AddConstructor<RotatingSybilApp>()
+      .AddAttribute("Identities", "Number of spoofed identities",
+                    UintegerValue(64),
+                    MakeUintegerAccessor(&RotatingSybilApp::m_numIdentities),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("FirstIdentity", "Lowest spoofed source address",
+                    Ipv4AddressValue("10.0.1.1"),
+                    MakeIpv4AddressAccessor(&RotatingSybilApp::m_firstIdentity),
+                    MakeIpv4AddressChecker())
+      .AddAttribute("MaxRate", "Packets per window the targeted detector accepts from one source",
+                    UintegerValue(3),
+                    MakeUintegerAccessor(&RotatingSybilApp::m_maxRate),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("Window", "Window of the targeted detector",
+                    TimeValue(Seconds(5.0)),
+                    MakeTimeAccessor(&RotatingSybilApp::m_window),
+                    MakeTimeChecker())
+      .AddAttribute("Margin", "Fraction by which each identity's spacing exceeds Window / MaxRate",
+                    DoubleValue(0.05),
+                    MakeDoubleAccessor(&RotatingSybilApp::m_margin),
+                    MakeDoubleChecker<double>(0.0))
+      .AddAttribute("PacketSize", "Payload bytes per packet",
+                    UintegerValue(128),
+                    MakeUintegerAccessor(&RotatingSybilApp::m_packetSize),
+                    MakeUintegerChecker<uint32_t>());
+    return tid;
+  }
+
+private:
+  void StartApplication() override
+  {
+    m_sender.Attach(GetNode());
+    m_frames.clear();
+    for (uint32_t i = 0; i < m_numIdentities; ++i) {
+      Ipv4Address identity(m_firstIdentity.Get() + i);
+      g_attackerAddresses.insert(identity);
+      m_frames.push_back(BuildBroadcastFrame(identity, m_packetSize, 10));
+    }
+    // One full rotation per Window * (1 + Margin) / MaxRate
+    m_interval = Seconds(m_window.GetSeconds() * (1.0 + m_margin) / (m_maxRate * m_numIdentities));
+    m_event = Simulator::ScheduleNow(&RotatingSybilApp::Send, this);
+  }
+
+  void StopApplication() override
+  {
+    Simulator::Cancel(m_event);
+  }
+
+  void Send()
+  {
+    m_sender.Send(m_frames[m_next]);
+    m_next = (m_next + 1) % m_frames.size();
+    m_event = Simulator::Schedule(m_interval, &RotatingSybilApp::Send, this);
+  }
+
+  AttackFrameSender m_sender;
+  EventId m_event;
+  std::vector<std::vector<uint8_t>> m_frames;
+  uint32_t m_next = 0;
+  Time m_interval;
+  uint32_t m_numIdentities;
+  Ipv4Address m_firstIdentity;
+  uint32_t m_maxRate;
+  Time m_window;
+  double m_margin;
+  uint32_t m_packetSize;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(RotatingSybilApp);
+
+// -------------------- Defense plug-ins --------------------
+// Interface the engine drives from each defended node's IPv4 Rx trace
+class DefensePlugin : public Object
+{
+public:
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("DefensePlugin")
+      .SetParent<Object>();
+    return tid;
+  }
+
+  virtual bool ShouldAccept(Ipv4Address source) = 0;
+  virtual bool HasActivity() const = 0;
+  virtual void PrintReport(const std::string &label) = 0;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(DefensePlugin);
+
+// AdvancedDefenseManager: RateLimitCore, the rate limiter of
+// src/flooding-defence.cc; a source that exceeds it SuspiciousThreshold
+// times is blocked outright
+class AdvancedDefenseManager : public DefensePlugin
+{
+public:
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("AdvancedDefenseManager")
+      .SetParent<DefensePlugin>()
+      .AddConstructor<AdvancedDefenseManager>()
+      .AddAttribute("RreqLimit", "Packets accepted per source and window",
+                    UintegerValue(3),
+                    MakeUintegerAccessor(&AdvancedDefenseManager::m_rreqLimit),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("Window", "Rate-limit window",
+                    TimeValue(Seconds(1.0)),
+                    MakeTimeAccessor(&AdvancedDefenseManager::m_timeWindow),
+                    MakeTimeChecker())
+      .AddAttribute("SuspiciousThreshold", "Violations before a source is blocked",
+                    UintegerValue(10),
+                    MakeUintegerAccessor(&AdvancedDefenseManager::m_suspiciousThreshold),
+                    MakeUintegerChecker<uint32_t>(1));
+    return tid;
+  }
+
+  bool ShouldAccept(Ipv4Address source) override
+  {
+    RateLimitCore::Verdict verdict = m_core.Judge(source, Simulator::Now());
+    if (verdict == RateLimitCore::OVER_LIMIT) {
+      NS_LOG_INFO("Rate limit exceeded for " << source << " (violations: " << m_core.ViolationsOf(source) << ")");
+    }
+    return verdict == RateLimitCore::ACCEPT;
+  }
+
+  bool HasActivity() const override { return m_core.HasActivity(); }
+
+  void PrintReport(const std::string &label) override
+  {
+    std::cout << "\n========== Security Analysis Report " << label << "==========" << std::endl;
+    for (auto &entry : m_core.Violations()) {
+      std::string level = (entry.second >= m_suspiciousThreshold ? "HIGH"
+                           : (entry.second >= 5 ? "MEDIUM" : "LOW"));
+      std::cout << "  " << entry.first << " - Violations: " << entry.second
+                << " (Threat: " << level << ")" << std::endl;
+    }
+    std::cout << "===============================================" << std::endl;
+  }
+
+protected:
+  void NotifyConstructionCompleted() override
+  {
+    DefensePlugin::NotifyConstructionCompleted();
+    m_core.limit = m_rreqLimit;
+    m_core.window = m_timeWindow;
+    m_core.threshold = m_suspiciousThreshold;
+  }
+
+private:
+  RateLimitCore m_core;
+  uint32_t m_rreqLimit;
+  Time m_timeWindow;
+  uint32_t m_suspiciousThreshold;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(AdvancedDefenseManager);
+
+// SybilDetector: SybilCore, the detector of src/sybil-defence.cc, rate
+// limit over a longer window plus burst detection (BurstSize packets
+// inside BurstInterval); repeat offenders are blacklisted
+class SybilDetector : public DefensePlugin
+{
+public:
+  static TypeId GetTypeId(void)
+  {
+    static TypeId tid = TypeId("SybilDetector")
+      .SetParent<DefensePlugin>()
+      .AddConstructor<SybilDetector>()
+      .AddAttribute("Window", "Rate window",
+                    TimeValue(Seconds(5.0)),
+                    MakeTimeAccessor(&SybilDetector::m_window),
+                    MakeTimeChecker())
+      .AddAttribute("MaxRate", "Packets accepted per source and window",
+                    UintegerValue(3),
+                    MakeUintegerAccessor(&SybilDetector::m_maxRate),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("BurstSize", "Packets that count as a burst",
+                    UintegerValue(5),
+                    MakeUintegerAccessor(&SybilDetector::m_burstSize),
+                    MakeUintegerChecker<uint32_t>(1))
+      .AddAttribute("BurstInterval", "Span a burst must fit in",
+                    TimeValue(MilliSeconds(500)),
+                    MakeTimeAccessor(&SybilDetector::m_burstInterval),
+                    MakeTimeChecker())
+      .AddAttribute("BlacklistThreshold", "Violations before a source is blacklisted",
+                    UintegerValue(10),
+                    MakeUintegerAccessor(&SybilDetector::m_blacklistThreshold),
+                    MakeUintegerChecker<uint32_t>(1));
+    return tid;
+  }
+
+  bool ShouldAccept(Ipv4Address source) override
+  {
+    SybilCore::Verdict verdict = m_core.Judge(source, Simulator::Now());
+    if (verdict != SybilCore::ACCEPT && verdict != SybilCore::BLACKLISTED) {
+      NS_LOG_INFO("Sybil detector violation by " << source << " (" << m_core.ViolationsOf(source) << ")");
+    }
+    return verdict == SybilCore::ACCEPT;
+  }
+
+  bool HasActivity() const override { return m_core.HasActivity(); }
+
+  void PrintReport(const std::string &label) override
+  {
+    std::cout << "\n===== Sybil Defense Report " << label << "=====" << std::endl;
+    for (const auto &kv : m_core.Violations()) {
+      std::cout << "IP " << kv.first << " -> Violations: " << kv.second
+                << (m_core.IsBlacklisted(kv.first) ? " (blacklisted)" : "") << std::endl;
+    }
+    std::cout << "================================" << std::endl;
+  }
+
+protected:
+  void NotifyConstructionCompleted() override
+  {
+    DefensePlugin::NotifyConstructionCompleted();
+    m_core.window = m_window;
+    m_core.maxRate = m_maxRate;
+    m_core.burstSize = m_burstSize;
+    m_core.burstInterval = m_burstInterval;
+    m_core.blacklistThreshold = m_blacklistThreshold;
+  }
+
+private:
+  SybilCore m_core;
+  Time m_window;
+  uint32_t m_maxRate;
+  uint32_t m_burstSize;
+  Time m_burstInterval;
+  uint32_t m_blacklistThreshold;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(SybilDetector);
+
+void DefenseRxCallback(Ptr<DefensePlugin> defense, Ptr<const Packet> p, Ptr<Ipv4>, uint32_t)
+{
+  Ipv4Header hdr;
+  if (!p->PeekHeader(hdr)) return;
+  bool accepted = defense->ShouldAccept(hdr.GetSource());
+  RecordVerdict(hdr.GetSource(), accepted);
+  if (!accepted) g_defenseDrops++;
+}
+
+// -------------------- Scenario runs --------------------
+// A scenario can be run more than once per process (benchmark suites), so
+// everything a run produces is collected here and the counters are reset
+// before each run.
+struct RunOptions {
+  uint32_t run = 0;      // RNG run override, 0 keeps the file's
+  bool attacks = true;   // false: attacker nodes stay in place but idle
+  bool defenses = true;
+  bool lean = false;
+  bool quiet = false;    // no per-run report
+};
+
+// Plain data, so a forked run can send it through a pipe
+struct ScenarioMetrics {
+  double simTime = 0.0;
+  uint32_t legitSent = 0;
+  uint32_t legitReceived = 0;
+  uint64_t legitBytes = 0;
+  uint64_t attackSent = 0;
+  uint64_t attackDecisions = 0;
+  uint64_t attackPassed = 0;    // attack packets a defense judged and accepted
+  uint64_t legitDecisions = 0;
+  uint64_t legitRejected = 0;
+  uint64_t defenseDrops = 0;
+  double wallSeconds = 0.0;
+
+  double Pdr() const { return legitSent ? 100.0 * legitReceived / legitSent : 0.0; }
+  double GoodputKbps() const { return simTime > 0 ? legitBytes * 8.0 / 1000.0 / simTime : 0.0; }
+};
+
+struct ScenarioResult : ScenarioMetrics {
+  std::string name;
+};
+
+void ResetCounters()
+{
+  g_packetsSent = g_packetsReceived = 0;
+  g_bytesReceived = g_attackPacketsSent = g_defenseDrops = 0;
+  ResetVerdicts();
+}
+
+void PrintScenarioResults(const ScenarioResult &r, bool defended)
+{
+  double tpr = r.attackDecisions ? 100.0 * (r.attackDecisions - r.attackPassed) / r.attackDecisions : 0.0;
+  double fpr = r.legitDecisions ? 100.0 * r.legitRejected / r.legitDecisions : 0.0;
+
+  std::cout << "\n========== Scenario Results: " << r.name << " ==========" << std::endl;
+  std::cout << "Legitimate Packets Sent:     " << r.legitSent << std::endl;
+  std::cout << "Legitimate Packets Received: " << r.legitReceived << std::endl;
+  std::cout << "Packet Delivery Ratio (%):   " << std::fixed << std::setprecision(2) << r.Pdr() << std::endl;
+  std::cout << "Legitimate Goodput (kbps):   " << r.GoodputKbps() << std::endl;
+  std::cout << "Attack Packets Generated:    " << r.attackSent << std::endl;
+  std::cout << "Attack Rate (pkt/sec):       " << r.attackSent / r.simTime << std::endl;
+  if (defended) {
+    std::cout << "Packets Dropped by Defense:  " << r.defenseDrops << std::endl;
+    std::cout << "Attack Packets Blocked (%):  " << tpr << std::endl;
+    std::cout << "Attack Packets Passed:       " << r.attackPassed << std::endl;
+    std::cout << "Legit Packet FPR (%):        " << fpr
+              << " (" << r.legitRejected << "/" << r.legitDecisions << ")" << std::endl;
+  }
+  std::cout << "=====================================================" << std::endl;
+}
+
+// Builds the network described by `sections`, runs it to completion and
+// tears it down again
+ScenarioResult RunScenario(std::vector<ConfigSection> sections, const std::string &fallbackName,
+                           const RunOptions &options)
+{
+  ResetCounters();
+  Ipv4AddressGenerator::Reset(); // every run in the process reuses 10.0.0.0/24
+
+  // Scenario
+  ConfigSection &scenario = SingleSection(sections, "scenario");
+  std::string scenarioName = scenario.GetString("name", fallbackName);
+  uint32_t numNodes = scenario.GetUint("nodes", 15);
+  double simTime = scenario.GetDouble("simTime", 30.0);
+  RngSeedManager::SetSeed(scenario.GetUint("seed", 1));
+  RngSeedManager::SetRun(options.run ? options.run : scenario.GetUint("run", 1));
+  scenario.CheckAllUsed();
+  NS_ABORT_MSG_IF(numNodes < 2, "[scenario] nodes must be at least 2");
+
+  ConfigSection &output = SingleSection(sections, "output");
+  std::string pcapPrefix = output.GetString("pcap", "");
+  std::string animFile = output.GetString("anim", "");
+  bool logging = output.GetBool("log", false);
+  output.CheckAllUsed();
+  if (options.lean) {
+    pcapPrefix.clear();
+    animFile.clear();
+    logging = false;
+  }
+  if (logging) {
+    LogComponentEnable("ScenarioEngine", LOG_LEVEL_INFO);
+  }
+
+  NodeContainer nodes;
+  nodes.Create(numNodes);
+
+  // Attack sections are read up front: attacker nodes may be pinned in
+  // place and are left out of the default defended set
+  std::vector<ConfigSection *> attackSections;
+  std::set<uint32_t> attackerNodes;
+  std::map<uint32_t, Vector> pinned;
+  for (auto &section : sections) {
+    if (section.kind != "attack") continue;
+    attackSections.push_back(&section);
+    std::string fallback = std::to_string(numNodes - 1);
+    if (!section.Has("nodes")) section.values["nodes"] = fallback;
+    for (uint32_t n : section.GetNodeList("nodes", numNodes)) {
+      attackerNodes.insert(n);
+      if (section.Has("position")) {
+        std::istringstream in(section.GetString("position", ""));
+        Vector pos;
+        in >> pos.x >> pos.y;
+        NS_ABORT_MSG_IF(in.fail(), section.Label() << " position: expected \"x y\"");
+        pinned[n] = pos;
+      }
+    }
+  }
+
+  // Wi-Fi
+  ConfigSection &wifiSection = SingleSection(sections, "wifi");
+  WifiHelper wifi;
+  wifi.SetStandard(WIFI_STANDARD_80211b);
+  wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager",
+    "DataMode", StringValue(wifiSection.GetString("dataMode", "DsssRate11Mbps")),
+    "ControlMode", StringValue(wifiSection.GetString("controlMode", "DsssRate1Mbps")));
+  // Broadcasts go at the basic rate unless set here
+  std::string nonUnicastMode = wifiSection.GetString("nonUnicastMode", "");
+  wifiSection.CheckAllUsed();
+
+  YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
+  YansWifiPhyHelper phy;
+  phy.SetChannel(channel.Create());
+
+  WifiMacHelper mac;
+  mac.SetType("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install(phy, mac, nodes);
+  if (!nonUnicastMode.empty()) {
+    for (uint32_t i = 0; i < devices.GetN(); ++i) {
+      DynamicCast<WifiNetDevice>(devices.Get(i))->GetRemoteStationManager()->SetAttribute(
+        "NonUnicastMode", StringValue(nonUnicastMode));
+    }
+  }
+  // Fixed stream numbers, so runs that differ only in their plug-ins (the
+  // --paired variants) see the same channel, movement and routing jitter
+  int64_t stream = wifi.AssignStreams(devices, 0);
+
+  // Mobility: grid start, random walk inside the bounds; pinned attackers stay put
+  ConfigSection &mob = SingleSection(sections, "mobility");
+  double minX = mob.GetDouble("minX", 100.0);
+  double minY = mob.GetDouble("minY", 100.0);
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator("ns3::GridPositionAllocator",
+    "MinX", DoubleValue(minX), "MinY", DoubleValue(minY),
+    "DeltaX", DoubleValue(mob.GetDouble("deltaX", 80.0)), "DeltaY", DoubleValue(mob.GetDouble("deltaY", 80.0)),
+    "GridWidth", UintegerValue(mob.GetUint("gridWidth", 5)), "LayoutType", StringValue("RowFirst"));
+  Rectangle bounds(mob.GetDouble("boundMinX", minX - 50.0), mob.GetDouble("boundMaxX", 550.0),
+                   mob.GetDouble("boundMinY", minY - 50.0), mob.GetDouble("boundMaxY", 550.0));
+  std::string speed = mob.GetString("speed", "ns3::UniformRandomVariable[Min=1.0|Max=4.0]");
+  if (mob.Has("distance")) {
+    mobility.SetMobilityModel("ns3::RandomWalk2dMobilityModel",
+      "Bounds", RectangleValue(bounds), "Speed", StringValue(speed),
+      "Distance", DoubleValue(mob.GetDouble("distance", 0.0)));
+  } else {
+    mobility.SetMobilityModel("ns3::RandomWalk2dMobilityModel",
+      "Bounds", RectangleValue(bounds), "Speed", StringValue(speed));
+  }
+  mob.CheckAllUsed();
+
+  NodeContainer mobileNodes;
+  for (uint32_t i = 0; i < numNodes; ++i) {
+    if (!pinned.count(i)) mobileNodes.Add(nodes.Get(i));
+  }
+  mobility.Install(mobileNodes);
+  stream += mobility.AssignStreams(mobileNodes, stream);
+  MobilityHelper fixedMobility;
+  fixedMobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+  for (auto &entry : pinned) {
+    fixedMobility.Install(nodes.Get(entry.first));
+    nodes.Get(entry.first)->GetObject<MobilityModel>()->SetPosition(entry.second);
+  }
+
+  // AODV: every key is an AodvHelper attribute
+  ConfigSection &aodvSection = SingleSection(sections, "aodv");
+  AodvHelper aodv;
+  for (auto &kv : aodvSection.Unused()) {
+    aodv.Set(kv.first, StringValue(kv.second));
+  }
+  InternetStackHelper stack;
+  stack.SetRoutingHelper(aodv);
+  stack.Install(nodes);
+  aodv.AssignStreams(nodes, stream);
+
+  Ipv4AddressHelper addr;
+  addr.SetBase("10.0.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer ifs = addr.Assign(devices);
+
+  // Legitimate traffic: one client/server pair per [traffic] section
+  for (auto &section : sections) {
+    if (section.kind != "traffic") continue;
+    std::string type = section.GetString("type", "udp");
+    uint32_t serverId = section.GetUint("server", numNodes - 2);
+    uint32_t clientId = section.GetUint("client", 0);
+    uint16_t port = section.GetUint("port", 9);
+    uint32_t maxPackets = section.GetUint("packets", 1000);
+    Time interval = Seconds(section.GetDouble("interval", 0.1));
+    uint32_t packetSize = section.GetUint("packetSize", 512);
+    double start = section.GetDouble("start", 2.0);
+    double stop = section.GetDouble("stop", simTime);
+    section.CheckAllUsed();
+    NS_ABORT_MSG_IF(serverId >= numNodes || clientId >= numNodes, section.Label() << ": node out of range");
+
+    ApplicationContainer serverApps, clientApps;
+    if (type == "udp") {
+      UdpServerHelper server(port);
+      serverApps = server.Install(nodes.Get(serverId));
+      UdpClientHelper client(ifs.GetAddress(serverId), port);
+      client.SetAttribute("MaxPackets", UintegerValue(maxPackets));
+      client.SetAttribute("Interval", TimeValue(interval));
+      client.SetAttribute("PacketSize", UintegerValue(packetSize));
+      clientApps = client.Install(nodes.Get(clientId));
+    } else if (type == "echo") {
+      UdpEchoServerHelper server(port);
+      serverApps = server.Install(nodes.Get(serverId));
+      UdpEchoClientHelper client(ifs.GetAddress(serverId), port);
+      client.SetAttribute("MaxPackets", UintegerValue(maxPackets));
+      client.SetAttribute("Interval", TimeValue(interval));
+      client.SetAttribute("PacketSize", UintegerValue(packetSize));
+      clientApps = client.Install(nodes.Get(clientId));
+    } else {
+      NS_ABORT_MSG(section.Label() << ": unknown traffic type '" << type << "' (use udp or echo)");
+    }
+    serverApps.Start(Seconds(1.0));
+    serverApps.Stop(Seconds(stop));
+    clientApps.Start(Seconds(start));
+    clientApps.Stop(Seconds(stop));
+    clientApps.Get(0)->TraceConnectWithoutContext("Tx", MakeCallback(&TxCallback));
+    serverApps.Get(0)->TraceConnectWithoutContext("Rx", MakeCallback(&RxCallback));
+  }
+
+  // Attack plug-ins
+  for (ConfigSection *section : attackSections) {
+    std::vector<uint32_t> hosts = section->GetNodeList("nodes", numNodes);
+    double start = section->GetDouble("start", 5.0);
+    double stop = section->GetDouble("stop", simTime - 1.0);
+    double txPower = section->GetDouble("txPower", 0.0);
+    ObjectFactory factory = ConfigurePlugin(*section, Application::GetTypeId());
+    for (uint32_t n : hosts) {
+      // The attacker's radio is part of the topology, so every variant
+      // gets it; only the application is left out without attacks
+      Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice>(devices.Get(n));
+      if (txPower > 0 && dev) {
+        Ptr<YansWifiPhy> attackerPhy = DynamicCast<YansWifiPhy>(dev->GetPhy());
+        if (attackerPhy) {
+          attackerPhy->SetTxPowerStart(txPower);
+          attackerPhy->SetTxPowerEnd(txPower);
+        }
+      }
+      if (!options.attacks) continue;
+      Ptr<Application> app = factory.Create<Application>();
+      nodes.Get(n)->AddApplication(app);
+      app->SetStartTime(Seconds(start));
+      app->SetStopTime(Seconds(stop));
+    }
+  }
+
+  // Defense plug-ins: one shared instance or one per defended node
+  struct DefenseInstall {
+    std::string label;
+    bool perNode;
+    std::vector<std::pair<uint32_t, Ptr<DefensePlugin>>> instances;
+  };
+  std::vector<DefenseInstall> defenses;
+  for (auto &section : sections) {
+    if (section.kind != "defense" || !options.defenses) continue;
+    std::vector<uint32_t> defended;
+    if (section.Has("nodes")) {
+      defended = section.GetNodeList("nodes", numNodes);
+    } else {
+      for (uint32_t i = 0; i < numNodes; ++i) {
+        if (!attackerNodes.count(i)) defended.push_back(i);
+      }
+    }
+    NS_ABORT_MSG_IF(defended.empty(), section.Label() << ": no nodes to defend");
+    std::string scope = section.GetString("scope", "shared");
+    NS_ABORT_MSG_UNLESS(scope == "shared" || scope == "per-node",
+                        section.Label() << ": scope must be shared or per-node");
+    ObjectFactory factory = ConfigurePlugin(section, DefensePlugin::GetTypeId());
+
+    DefenseInstall install;
+    install.label = section.Label();
+    install.perNode = scope == "per-node";
+    Ptr<DefensePlugin> shared;
+    if (!install.perNode) shared = factory.Create<DefensePlugin>();
+    for (uint32_t n : defended) {
+      Ptr<DefensePlugin> defense = install.perNode ? factory.Create<DefensePlugin>() : shared;
+      nodes.Get(n)->GetObject<Ipv4>()->TraceConnectWithoutContext(
+        "Rx", MakeBoundCallback(&DefenseRxCallback, defense));
+      install.instances.emplace_back(n, defense);
+    }
+    defenses.push_back(install);
+  }
+
+  if (!pcapPrefix.empty()) {
+    phy.EnablePcapAll(pcapPrefix);
+  }
+
+  std::unique_ptr<AnimationInterface> anim;
+  if (!animFile.empty()) {
+    anim = std::make_unique<AnimationInterface>(animFile);
+    for (uint32_t i = 0; i < numNodes; ++i) {
+      bool attacker = attackerNodes.count(i) > 0;
+      anim->UpdateNodeColor(nodes.Get(i), attacker ? 255 : 0, attacker ? 0 : 255, 0);
+      anim->UpdateNodeSize(nodes.Get(i)->GetId(), attacker ? 15 : 10, attacker ? 15 : 10);
+    }
+  }
+
+  if (!options.quiet) {
+    std::cout << "Scenario " << scenarioName << ": " << numNodes << " nodes, "
+              << (options.attacks ? attackerNodes.size() : 0) << " attackers, "
+              << defenses.size() << " defense plug-ins" << std::endl;
+  }
+
+  Simulator::Stop(Seconds(simTime));
+  auto wallStart = std::chrono::steady_clock::now();
+  Simulator::Run();
+
+  ScenarioResult result;
+  result.name = scenarioName;
+  result.simTime = simTime;
+  result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  result.legitSent = g_packetsSent;
+  result.legitReceived = g_packetsReceived;
+  result.legitBytes = g_bytesReceived;
+  result.attackSent = g_attackPacketsSent;
+  result.attackDecisions = g_attackDecisions;
+  result.attackPassed = g_attackDecisions - g_attackRejected;
+  result.legitDecisions = g_legitDecisions;
+  result.legitRejected = g_legitRejected;
+  result.defenseDrops = g_defenseDrops;
+
+  if (!options.quiet) {
+    PrintScenarioResults(result, !defenses.empty());
+    for (auto &install : defenses) {
+      if (!install.perNode) {
+        install.instances.front().second->PrintReport(install.label + " ");
+        continue;
+      }
+      for (auto &instance : install.instances) {
+        if (instance.second->HasActivity()) {
+          instance.second->PrintReport(install.label + " (node " + std::to_string(instance.first) + ") ");
+        }
+      }
+    }
+  }
+
+  anim.reset();
+  Simulator::Destroy();
+  return result;
+}
+
+// RunScenario in a forked child. Consecutive runs in one process would not
+// see the same random streams: every auto-assigned stream number continues
+// from the previous run's.
+ScenarioResult RunScenarioForked(const std::vector<ConfigSection> &sections, const std::string &fallbackName,
+                                 const RunOptions &options)
+{
+  int fds[2];
+  NS_ABORT_MSG_IF(pipe(fds) != 0, "pipe() failed");
+  std::cout.flush();
+  pid_t pid = fork();
+  NS_ABORT_MSG_IF(pid < 0, "fork() failed");
+  if (pid == 0) {
+    close(fds[0]);
+    ScenarioResult r = RunScenario(sections, fallbackName, options);
+    const ScenarioMetrics &metrics = r;
+    bool ok = write(fds[1], &metrics, sizeof(metrics)) == sizeof(metrics);
+    _exit(ok ? 0 : 1);
+  }
+  close(fds[1]);
+  ScenarioResult result;
+  std::vector<ConfigSection> copy = sections;
+  result.name = SingleSection(copy, "scenario").GetString("name", fallbackName);
+  ScenarioMetrics &metrics = result;
+  int status;
+  waitpid(pid, &status, 0);
+  bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0
+            && read(fds[0], &metrics, sizeof(metrics)) == sizeof(metrics);
+  close(fds[0]);
+  NS_ABORT_MSG_UNLESS(ok, "Run of " << result.name << " failed");
+  return result;
+}
+
+// -------------------- Evasion benchmark --------------------
+// Suite file: one scenario path per line (relative to the suite file),
+// '#' comments. Each scenario runs twice with the same seed, attacks off
+// and on, defenses on both times, each run in its own child process so the
+// two are paired. One row per scenario reports how much attack traffic the
+// detectors let through and what the attack cost legitimate traffic. A path
+// followed by "at-limit" marks an attacker paced exactly at the detector's
+// limit: every attack packet judged must pass, or the suite fails.
+struct BenchmarkRow {
+  ScenarioResult baseline;
+  ScenarioResult attacked;
+  bool atLimit;
+};
+
+int RunBenchmark(const std::string &suiteFile, const RunOptions &options)
+{
+  std::ifstream in(suiteFile);
+  NS_ABORT_MSG_UNLESS(in, "Cannot open benchmark suite " << suiteFile);
+  std::string dir = suiteFile.find('/') == std::string::npos ? ""
+                    : suiteFile.substr(0, suiteFile.rfind('/') + 1);
+
+  std::vector<BenchmarkRow> rows;
+  std::string raw;
+  while (std::getline(in, raw)) {
+    std::istringstream line(raw.substr(0, raw.find('#')));
+    std::string path, mark;
+    if (!(line >> path)) continue;
+    line >> mark;
+    NS_ABORT_MSG_UNLESS(mark.empty() || mark == "at-limit", suiteFile << ": unknown mark '" << mark << "'");
+    if (path.front() != '/') path = dir + path;
+    std::vector<ConfigSection> sections = ParseScenarioFile(path);
+    RunOptions clean = options;
+    clean.attacks = false;
+    BenchmarkRow row{RunScenarioForked(sections, path, clean), RunScenarioForked(sections, path, options),
+                     mark == "at-limit"};
+    std::cout << "  " << row.attacked.name << " done (" << std::fixed << std::setprecision(1)
+              << row.baseline.wallSeconds + row.attacked.wallSeconds << " s)" << std::endl;
+    rows.push_back(row);
+  }
+
+  std::cout << "\n========== Evasion Benchmark: " << suiteFile << " ==========" << std::endl;
+  std::cout << std::left << std::setw(28) << "Scenario" << std::right
+            << std::setw(10) << "AttackTx" << std::setw(10) << "Passed" << std::setw(9) << "Pass%"
+            << std::setw(10) << "PDR0%" << std::setw(10) << "PDR%" << std::setw(12) << "GoodputCost%"
+            << std::setw(9) << "LegitFP" << std::endl;
+  for (auto &row : rows) {
+    const ScenarioResult &base = row.baseline;
+    const ScenarioResult &att = row.attacked;
+    double pass = att.attackDecisions ? 100.0 * att.attackPassed / att.attackDecisions : 0.0;
+    double cost = base.GoodputKbps() > 0 ? 100.0 * (1.0 - att.GoodputKbps() / base.GoodputKbps()) : 0.0;
+    std::cout << std::left << std::setw(28) << att.name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << att.attackSent << std::setw(10) << att.attackPassed << std::setw(9) << pass
+              << std::setw(10) << base.Pdr() << std::setw(10) << att.Pdr() << std::setw(12) << cost
+              << std::setw(9) << att.legitRejected << std::endl;
+  }
+
+  uint32_t checks = 0, failures = 0;
+  for (auto &row : rows) {
+    if (!row.atLimit) continue;
+    checks++;
+    const ScenarioResult &att = row.attacked;
+    if (att.attackDecisions == 0 || att.attackPassed != att.attackDecisions) {
+      failures++;
+      std::cout << "AT-LIMIT FAILED: " << att.name << " passed " << att.attackPassed << " of "
+                << att.attackDecisions << " attack packets judged" << std::endl;
+    }
+  }
+  if (checks > 0) {
+    std::cout << "At-limit checks passed:      " << checks - failures << "/" << checks << std::endl;
+  }
+  std::cout << "=====================================================" << std::endl;
+  return failures > 0 ? 1 : 0;
+}
+
+// -------------------- Paired runs --------------------
+// Replication r runs the scenario three times on RNG run base + r with fixed
+// stream numbers: clean (no attack, no defense), attacked, and defended.
+// The three share mobility, channel and traffic, so per-pair differences
+// cancel most of the scenario noise (common random numbers). Every run is a
+// forked child, `jobs` at a time, that reports its metrics through a pipe.
+enum PairedVariant { VARIANT_CLEAN, VARIANT_ATTACKED, VARIANT_DEFENDED, VARIANT_COUNT };
+const char *const g_variantNames[VARIANT_COUNT] = {"clean", "attacked", "defended"};
+
+struct PairedSample {
+  double pdr = 0.0;
+  double goodput = 0.0;
+  double attackSent = 0.0;
+  double attackPassed = 0.0;
+  double wallSeconds = 0.0;
+};
+
+// Sample mean and variance
+std::pair<double, double> MeanVar(const std::vector<double> &x)
+{
+  double mean = 0.0, var = 0.0;
+  for (double v : x) mean += v;
+  mean /= x.size();
+  for (double v : x) var += (v - mean) * (v - mean);
+  return {mean, x.size() > 1 ? var / (x.size() - 1) : 0.0};
+}
+
+// One row per difference b - a: paired CI against the CI the same samples
+// would give as independent runs, and the resulting variance reduction
+void PrintPairedDifference(const std::string &label, const std::vector<double> &a, const std::vector<double> &b)
+{
+  size_t n = a.size();
+  std::vector<double> diff(n);
+  for (size_t i = 0; i < n; ++i) diff[i] = b[i] - a[i];
+  auto d = MeanVar(diff);
+  double unpairedVar = MeanVar(a).second + MeanVar(b).second;
+  double t = StudentT95(n - 1);
+  std::cout << "  " << std::left << std::setw(26) << label << std::right << std::fixed << std::setprecision(2)
+            << std::setw(9) << d.first << " +/- " << std::setw(6) << t * std::sqrt(d.second / n)
+            << "   unpaired +/- " << std::setw(6) << t * std::sqrt(unpairedVar / n);
+  if (d.second > 0) {
+    std::cout << "   variance reduction " << std::setprecision(1) << unpairedVar / d.second << "x";
+  }
+  std::cout << std::endl;
+}
+
+int RunPaired(const std::vector<ConfigSection> &sections, const std::string &configFile,
+              uint32_t replications, uint32_t jobs, const RunOptions &options)
+{
+  uint32_t baseRun = options.run;
+  if (baseRun == 0) {
+    std::vector<ConfigSection> copy = sections;
+    baseRun = SingleSection(copy, "scenario").GetUint("run", 1);
+  }
+  std::vector<std::array<PairedSample, VARIANT_COUNT>> samples(replications);
+
+  struct Child {
+    uint32_t replication;
+    PairedVariant variant;
+    int fd;
+  };
+  std::map<pid_t, Child> running;
+  uint32_t next = 0, total = replications * VARIANT_COUNT;
+  auto begin = std::chrono::steady_clock::now();
+  while (next < total || !running.empty()) {
+    while (next < total && running.size() < jobs) {
+      Child child{next / VARIANT_COUNT, PairedVariant(next % VARIANT_COUNT), -1};
+      int fds[2];
+      NS_ABORT_MSG_IF(pipe(fds) != 0, "pipe() failed");
+      pid_t pid = fork();
+      NS_ABORT_MSG_IF(pid < 0, "fork() failed");
+      if (pid == 0) {
+        close(fds[0]);
+        RunOptions opt = options;
+        opt.run = baseRun + child.replication;
+        opt.attacks = child.variant != VARIANT_CLEAN;
+        opt.defenses = child.variant == VARIANT_DEFENDED;
+        ScenarioResult r = RunScenario(sections, configFile, opt);
+        PairedSample sample;
+        sample.pdr = r.Pdr();
+        sample.goodput = r.GoodputKbps();
+        sample.attackSent = r.attackSent;
+        sample.attackPassed = r.attackPassed;
+        sample.wallSeconds = r.wallSeconds;
+        bool ok = write(fds[1], &sample, sizeof(sample)) == sizeof(sample);
+        _exit(ok ? 0 : 1);
+      }
+      close(fds[1]);
+      child.fd = fds[0];
+      running[pid] = child;
+      next++;
+    }
+
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    auto it = running.find(pid);
+    if (it == running.end()) continue;
+    Child child = it->second;
+    running.erase(it);
+    PairedSample &sample = samples[child.replication][child.variant];
+    bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0
+              && read(child.fd, &sample, sizeof(sample)) == sizeof(sample);
+    close(child.fd);
+    NS_ABORT_MSG_UNLESS(ok, "Run " << baseRun + child.replication << " (" << g_variantNames[child.variant]
+                        << ") failed");
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  std::vector<double> pdr[VARIANT_COUNT], goodput[VARIANT_COUNT];
+  double cpu = 0.0;
+  for (auto &rep : samples) {
+    for (int v = 0; v < VARIANT_COUNT; ++v) {
+      pdr[v].push_back(rep[v].pdr);
+      goodput[v].push_back(rep[v].goodput);
+      cpu += rep[v].wallSeconds;
+    }
+  }
+
+  std::cout << "\n========== Paired Runs: " << configFile << " ==========" << std::endl;
+  std::cout << "Replications:                " << replications << " (runs " << baseRun << "-"
+            << baseRun + replications - 1 << ", " << jobs << " concurrent)" << std::endl;
+  std::cout << "Wall / summed run time (s):  " << std::fixed << std::setprecision(1) << wall << " / " << cpu << std::endl;
+  std::cout << "\nvariant       PDR (%)        goodput (kbps)   attack sent/passed" << std::endl;
+  for (int v = 0; v < VARIANT_COUNT; ++v) {
+    auto p = MeanVar(pdr[v]);
+    auto g = MeanVar(goodput[v]);
+    double sent = 0.0, passed = 0.0;
+    for (auto &rep : samples) {
+      sent += rep[v].attackSent;
+      passed += rep[v].attackPassed;
+    }
+    double t = StudentT95(replications - 1);
+    std::cout << std::left << std::setw(10) << g_variantNames[v] << std::right << std::setprecision(2)
+              << std::setw(8) << p.first << " +/- " << std::setw(5) << t * std::sqrt(p.second / replications)
+              << std::setw(9) << g.first << " +/- " << std::setw(6) << t * std::sqrt(g.second / replications)
+              << std::setprecision(0) << std::setw(11) << sent / replications << " / " << passed / replications
+              << std::endl;
+  }
+  std::cout << "\nrun        PDR clean  attacked  defended    impact      gain" << std::endl;
+  for (uint32_t r = 0; r < replications; ++r) {
+    std::cout << std::left << std::setw(8) << baseRun + r << std::right << std::setprecision(2)
+              << std::setw(12) << pdr[VARIANT_CLEAN][r] << std::setw(10) << pdr[VARIANT_ATTACKED][r]
+              << std::setw(10) << pdr[VARIANT_DEFENDED][r]
+              << std::setw(10) << pdr[VARIANT_ATTACKED][r] - pdr[VARIANT_CLEAN][r]
+              << std::setw(10) << pdr[VARIANT_DEFENDED][r] - pdr[VARIANT_ATTACKED][r] << std::endl;
+  }
+  std::cout << "\nPaired differences (mean +/- 95% CI):" << std::endl;
+  PrintPairedDifference("PDR attack impact (%)", pdr[VARIANT_CLEAN], pdr[VARIANT_ATTACKED]);
+  PrintPairedDifference("PDR defense gain (%)", pdr[VARIANT_ATTACKED], pdr[VARIANT_DEFENDED]);
+  PrintPairedDifference("PDR residual loss (%)", pdr[VARIANT_CLEAN], pdr[VARIANT_DEFENDED]);
+  PrintPairedDifference("Goodput impact (kbps)", goodput[VARIANT_CLEAN], goodput[VARIANT_ATTACKED]);
+  PrintPairedDifference("Goodput defense gain (kbps)", goodput[VARIANT_ATTACKED], goodput[VARIANT_DEFENDED]);
+  std::cout << "=====================================================" << std::endl;
+  return 0;
+}
+
+// -------------------- Main --------------------
+int main(int argc, char *argv[])
+{
+  std::string configFile = "";
+  std::string benchSuite = "";
+  uint32_t paired = 0;
+  uint32_t jobs = std::max(1u, std::thread::hardware_concurrency());
+  RunOptions options;
+  bool perfReport = false;
+
+  CommandLine cmd;
+  cmd.AddValue("config", "Scenario file to run", configFile);
+  cmd.AddValue("bench", "Run every scenario of a suite file with attacks off and on and tabulate evasion", benchSuite);
+  cmd.AddValue("paired", "Run this many replications of clean, attacked and defended variants and compare them", paired);
+  cmd.AddValue("jobs", "Concurrent runs in paired mode", jobs);
+  cmd.AddValue("run", "Override the scenario's RNG run number (0 keeps it)", options.run);
+  cmd.AddValue("lean", "Headless batch mode: no NetAnim, PCAP or logging, counters only", options.lean);
+  cmd.AddValue("perfReport", "Report run time and peak memory", perfReport);
+  cmd.Parse(argc, argv);
+
+  if (!benchSuite.empty()) {
+    options.lean = true;
+    options.quiet = true;
+    return RunBenchmark(benchSuite, options);
+  }
+
+  NS_ABORT_MSG_IF(configFile.empty(), "Usage: scenario-engine --config=<file> [--paired=N] | --bench=<suite>");
+  if (paired > 0) {
+    NS_ABORT_MSG_IF(paired < 2, "Paired mode needs at least two replications");
+    options.lean = true;
+    options.quiet = true;
+    return RunPaired(ParseScenarioFile(configFile), configFile, paired, std::max(jobs, 1u), options);
+  }
+  ScenarioResult result = RunScenario(ParseScenarioFile(configFile), configFile, options);
+
+  if (options.lean || perfReport) {
+    PrintRunPerformance(options.lean, result.wallSeconds);
+  }
+
+  return 0;
+}
@@ -11,6 +11,9 @@
 #include <vector>
 #include <iomanip>
 #include <iostream>
+#include <chrono>
+#include <memory>
+#include "run-performance.h"
 
 using namespace ns3;
 
@@ -130,14 +133,31 @@ int main(int argc, char *argv[])
     uint32_t nNodes = 10;
     uint32_t numSybilIds = 6;
     bool enablePcap = true;
+    bool lean = false;
+    bool perfReport = false;
+    bool comparePerf = false;
 
     CommandLine cmd(__FILE__);
     cmd.AddValue("nNodes", "Number of legitimate nodes", nNodes);
     cmd.AddValue("numSybilIds", "Number of Sybil identities", numSybilIds);
     cmd.AddValue("enablePcap", "Enable PCAP tracing", enablePcap);
+    cmd.AddValue("lean", "Headless batch mode: no NetAnim, PCAP or logging, counters only", lean);
+    cmd.AddValue("perfReport", "Report run time and peak memory", perfReport);
+    cmd.AddValue("comparePerf", "Run full and then lean in child processes and print the ratios", comparePerf);
     cmd.Parse(argc, argv);
 
-    LogComponentEnable("SybilAttackSimulation", LOG_LEVEL_INFO);
+    if (comparePerf) {
+        perfReport = true;
+        if (!ForkPerfComparison(lean)) {
+            return 0;
+        }
+    }
+
+    if (lean) {
+        enablePcap = false;
+    } else {
+        LogComponentEnable("SybilAttackSimulation", LOG_LEVEL_INFO);
+    }
 
     NodeContainer allNodes;
     allNodes.Create(nNodes + 1);
@@ -233,20 +253,30 @@ int main(int argc, char *argv[])
         phyHelper.EnablePcapAll("sybil-attack");
     }
 
-    // NetAnim Visualization
-    AnimationInterface anim("sybil-attack.xml");
-    for (uint32_t i = 0; i < nNodes; ++i) {
-        anim.UpdateNodeColor(allNodes.Get(i), 0, 255, 0);
-        anim.UpdateNodeSize(allNodes.Get(i)->GetId(), 25, 25);
+    // NetAnim Visualization (it tags every packet, so not in lean mode)
+    std::unique_ptr<AnimationInterface> anim;
+    if (!lean) {
+        anim = std::make_unique<AnimationInterface>("sybil-attack.xml");
+        for (uint32_t i = 0; i < nNodes; ++i) {
+            anim->UpdateNodeColor(allNodes.Get(i), 0, 255, 0);
+            anim->UpdateNodeSize(allNodes.Get(i)->GetId(), 25, 25);
+        }
+        anim->UpdateNodeColor(maliciousNode, 255, 0, 0);
+        anim->UpdateNodeSize(maliciousNode->GetId(), 50, 50);
     }
-    anim.UpdateNodeColor(maliciousNode, 255, 0, 0);
-    anim.UpdateNodeSize(maliciousNode->GetId(), 50, 50);
 
     // Run Simulation
     Simulator::Stop(Seconds(125.0));
     Simulator::Schedule(Seconds(121.0), &PrintFinalStatistics);
+    auto wallStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    anim.reset();
     Simulator::Destroy();
 
+    if (lean || perfReport) {
+        PrintRunPerformance(lean, wallSeconds);
+    }
+
     return 0;
 }
@@ -6,12 +6,24 @@
 #include "ns3/aodv-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/netanim-module.h"
+#include "ns3/energy-module.h"
+#include "manet-common.h"
+#include "run-performance.h"
 #include <iostream>
 #include <vector>
 #include <map>
 #include <deque>
 #include <set>
+#include <unordered_map>
 #include <iomanip>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <chrono>
+#include <memory>
 
 using namespace ns3;
 
@@ -27,61 +39,296 @@ uint32_t g_attackPacketsDropped = 0;
 double g_detectionWindowSeconds = 5.0;
 uint32_t g_maxAllowedRate = 3;
 uint32_t g_burstSizeThreshold = 5;
+uint32_t g_blacklistThreshold = 10;
+bool g_defenseEnabled = true; // detectors only observe the Rx trace; nothing is dropped
 
-// Detector class with rate and burst attack detection
+// Detector class with rate and burst attack detection, over SybilCore
 class SybilDetector : public Object
 {
 public:
-  bool ShouldAccept(Ipv4Address src)
+  SybilDetector()
   {
-    Time now = Simulator::Now();
-    auto &times = m_packetTimes[src];
-    while (!times.empty() && (now - times.front()).GetSeconds() > g_detectionWindowSeconds)
-      times.pop_front();
+    m_core.window = Seconds(g_detectionWindowSeconds);
+    m_core.maxRate = g_maxAllowedRate;
+    m_core.burstSize = g_burstSizeThreshold;
+    m_core.blacklistThreshold = g_blacklistThreshold;
+    m_core.onBlacklisted = MakeCallback(&SybilDetector::OnBlacklisted, this);
+  }
 
-    if (times.size() >= g_maxAllowedRate)
-    {
-      g_attackPacketsDropped++;
-      m_violationCounts[src]++;
-      NS_LOG_INFO(now.GetSeconds() << "s: [DEFENSE] Rate limit exceeded by " << src
-                   << ", violations: " << m_violationCounts[src]);
+  bool ShouldAccept(Ipv4Address src) { return ShouldAccept(src, Simulator::Now()); }
+
+  bool ShouldAccept(Ipv4Address src, Time now)
+  {
+    bool accepted = Apply(src, m_core.Judge(src, now));
+    RecordVerdict(src, accepted);
+    return accepted;
+  }
+
+  // Batched mode: queue the arrival; its verdict is applied when the tick ends
+  void Enqueue(Ipv4Address src)
+  {
+    Enqueue(src, Simulator::Now());
+    if (!m_flushEvent.IsRunning())
+      m_flushEvent = Simulator::Schedule(g_batchTick, &SybilDetector::FlushBatch, this);
+  }
+
+  void Enqueue(Ipv4Address src, Time now) { m_core.Enqueue(src, now); }
+
+  void FlushBatch()
+  {
+    auto begin = std::chrono::steady_clock::now();
+    size_t arrivals = m_core.Flush([this](Ipv4Address src, SybilCore::Verdict verdict)
+                                   { RecordVerdict(src, Apply(src, verdict)); });
+    RecordRealtimeFlush(begin, arrivals);
+  }
+
+  // Pre-emptively blacklist a source reported by a neighbour; false if already listed
+  bool Quarantine(Ipv4Address src)
+  {
+    if (!m_core.Quarantine(src))
       return false;
+    RecordDetection(src);
+    NS_LOG_INFO(Simulator::Now().GetSeconds() << "s: [DEFENSE] Quarantined " << src
+                                              << " on neighbour report");
+    return true;
+  }
+
+  // Invoked once per source when it is blacklisted locally
+  void SetBlacklistCallback(Callback<void, Ipv4Address> cb) { m_blacklistCallback = cb; }
+
+  bool HasActivity() const { return m_core.HasActivity(); }
+
+  uint32_t GetTrackedSources() const { return m_core.TrackedSources(); }
+
+  uint32_t GetBlacklistedSources() const { return m_core.BlacklistedSources(); }
+
+  void PrintReport(const std::string &label = "")
+  {
+    std::cout << "\n===== Sybil Defense Report " << label << "=====\n";
+    for (const auto &kv : m_core.Violations())
+    {
+      std::cout << "IP " << kv.first << " -> Violations: " << kv.second
+                << (m_core.IsBlacklisted(kv.first) ? " (blacklisted)" : "") << "\n";
+    }
+    std::cout << "================================\n";
+  }
+
+private:
+  // Counts and logs one verdict; true if the packet is accepted
+  bool Apply(Ipv4Address src, SybilCore::Verdict verdict)
+  {
+    if (verdict == SybilCore::ACCEPT)
+      return true;
+    g_attackPacketsDropped++;
+    if (verdict != SybilCore::BLACKLISTED)
+      NS_LOG_INFO(Simulator::Now().GetSeconds() << "s: [DEFENSE] " << Describe(verdict) << " " << src
+                   << ", violations: " << m_core.ViolationsOf(src));
+    return false;
+  }
+
+  static const char *Describe(SybilCore::Verdict verdict)
+  {
+    switch (verdict)
+    {
+    case SybilCore::OVER_RATE:
+      return "Rate limit exceeded by";
+    case SybilCore::BURST:
+      return "Burst attack detected from";
+    case SybilCore::BASELINE:
+      return "Baseline deviation by";
+    default:
+      return "Dropped";
     }
+  }
+
+  void OnBlacklisted(Ipv4Address src)
+  {
+    NS_LOG_INFO(Simulator::Now().GetSeconds() << "s: [DEFENSE] Blacklisted " << src);
+    RecordDetection(src);
+    if (!m_blacklistCallback.IsNull())
+      m_blacklistCallback(src);
+  }
 
-    times.push_back(now);
+  SybilCore m_core;
+  Callback<void, Ipv4Address> m_blacklistCallback;
+  EventId m_flushEvent;
+};
 
-    if (times.size() >= g_burstSizeThreshold)
+// One detector per node; in shared mode every entry points at the same instance
+std::vector<Ptr<SybilDetector>> g_detectors;
+
+// Fingerprint parameters
+double g_fpRssiTolerance = 3.0;      // dB band that counts as one transmitter
+uint32_t g_fpIdentityThreshold = 3;  // distinct IPs per fingerprint before flagging
+uint32_t g_fingerprintDrops = 0;
+
+// PHY fingerprint detector: every Sybil identity leaves the same radio, so
+// (transmitter MAC, RSSI band) is shared across all the IPs it claims. Each
+// node keeps a fixed number of fingerprint clusters; each cluster holds a
+// 64-bit hashed set of claimed IPs (linear counting), so memory per node is
+// constant no matter how many identities are spoofed.
+class PhyFingerprintDetector : public Object
+{
+public:
+  static const uint32_t kClustersPerNode = 8;
+
+  void Resize(uint32_t nNodes)
+  {
+    m_nodes.assign(nNodes, NodeState());
+  }
+
+  // Called from the MonitorSnifferRx trace for broadcast IPv4 frames
+  void Observe(uint32_t nodeId, Mac48Address mac, double rssiDbm, Ipv4Address src)
+  {
+    NodeState &node = m_nodes[nodeId];
+    Cluster *c = Match(node, mac, rssiDbm);
+    c->rssiDbm += 0.1 * (rssiDbm - c->rssiDbm);
+    c->ipBits |= (uint64_t(1) << IpBit(src));
+    c->lastSeen = Simulator::Now();
+
+    if (!c->flagged && EstimateIdentities(c->ipBits) >= g_fpIdentityThreshold)
     {
-      if ((now - times[times.size() - g_burstSizeThreshold]).GetSeconds() < 0.5)
+      c->flagged = true;
+      NS_LOG_INFO(Simulator::Now().GetSeconds() << "s: [FINGERPRINT] Node " << nodeId
+                  << " flagged " << mac << " @ " << c->rssiDbm << " dBm claiming ~"
+                  << EstimateIdentities(c->ipBits) << " identities");
+    }
+
+    node.lastSrc = src;
+    node.lastTime = Simulator::Now();
+    node.lastFlagged = c->flagged;
+  }
+
+  // The IPv4 Rx trace fires in the same event as the sniffer trace for the
+  // frame that carried it, so the last verdict at this node applies.
+  bool IsFlagged(uint32_t nodeId, Ipv4Address src) const
+  {
+    const NodeState &node = m_nodes[nodeId];
+    return node.lastFlagged && node.lastSrc == src && node.lastTime == Simulator::Now();
+  }
+
+  void PrintReport() const
+  {
+    std::cout << "\n===== PHY Fingerprint Report =====\n";
+    for (uint32_t n = 0; n < m_nodes.size(); ++n)
+    {
+      for (const Cluster &c : m_nodes[n].clusters)
       {
-        g_attackPacketsDropped++;
-        m_violationCounts[src]++;
-        NS_LOG_INFO(now.GetSeconds() << "s: [DEFENSE] Burst attack detected from " << src
-                     << ", violations: " << m_violationCounts[src]);
-        return false;
+        if (c.used && c.flagged)
+        {
+          std::cout << "Node " << n << ": " << c.mac << " @ " << std::setprecision(1)
+                    << c.rssiDbm << " dBm -> ~" << EstimateIdentities(c.ipBits)
+                    << " identities\n";
+        }
       }
     }
+    std::cout << "Packets dropped by fingerprint: " << g_fingerprintDrops << "\n";
+    std::cout << "==================================\n";
+  }
 
-    return true;
+private:
+  struct Cluster
+  {
+    bool used = false;
+    bool flagged = false;
+    Mac48Address mac;
+    double rssiDbm = 0.0;
+    uint64_t ipBits = 0;
+    Time lastSeen;
+  };
+
+  struct NodeState
+  {
+    Cluster clusters[kClustersPerNode];
+    Ipv4Address lastSrc;
+    Time lastTime;
+    bool lastFlagged = false;
+  };
+
+  static uint32_t IpBit(Ipv4Address ip)
+  {
+    return (ip.Get() * 2654435761u) >> 26;
+  }
+
+  static uint32_t EstimateIdentities(uint64_t bits)
+  {
+    uint32_t zeros = 64 - __builtin_popcountll(bits);
+    if (zeros == 0)
+      return 64 * 4;
+    return static_cast<uint32_t>(std::lround(-64.0 * std::log(zeros / 64.0)));
   }
 
-  void PrintReport()
+  // Find the cluster for this transmitter, or recycle the least recently seen one
+  static Cluster *Match(NodeState &node, Mac48Address mac, double rssiDbm)
   {
-    std::cout << "\n===== Sybil Defense Report =====\n";
-    for (const auto &kv : m_violationCounts)
+    Cluster *victim = &node.clusters[0];
+    for (Cluster &c : node.clusters)
     {
-      std::cout << "IP " << kv.first << " -> Violations: " << kv.second << "\n";
+      if (c.used && c.mac == mac && std::fabs(c.rssiDbm - rssiDbm) <= g_fpRssiTolerance)
+        return &c;
+      if (!c.used)
+        victim = &c;
+      else if (victim->used && c.lastSeen < victim->lastSeen)
+        victim = &c;
     }
-    std::cout << "Total attack packets dropped: " << g_attackPacketsDropped << "\n";
-    std::cout << "================================\n";
+    *victim = Cluster();
+    victim->used = true;
+    victim->mac = mac;
+    victim->rssiDbm = rssiDbm;
+    return victim;
   }
 
-private:
-  std::map<Ipv4Address, std::deque<Time>> m_packetTimes;
-  std::map<Ipv4Address, uint32_t> m_violationCounts;
+  std::vector<NodeState> m_nodes;
 };
 
-Ptr<SybilDetector> g_detector;
+Ptr<PhyFingerprintDetector> g_fingerprint;
+
+void FingerprintSnifferRx(uint32_t nodeId, Ptr<const Packet> packet, uint16_t channelFreqMhz,
+                          WifiTxVector txVector, MpduInfo aMpdu, SignalNoiseDbm signalNoise,
+                          uint16_t staId)
+{
+  Ptr<Packet> copy = packet->Copy();
+  WifiMacHeader mac;
+  if (!copy->RemoveHeader(mac) || !mac.IsData() || !mac.GetAddr1().IsBroadcast())
+    return; // unicast frames carry forwarded traffic from other originators
+
+  LlcSnapHeader llc;
+  if (!copy->RemoveHeader(llc) || llc.GetType() != Ipv4L3Protocol::PROT_NUMBER)
+    return;
+
+  Ipv4Header ip;
+  if (!copy->PeekHeader(ip))
+    return;
+
+  g_fingerprint->Observe(nodeId, mac.GetAddr2(), signalNoise.signal, ip.GetSource());
+}
+
+bool g_gossipEnabled = false;
+
+bool QuarantineSource(Ptr<SybilDetector> detector, Ipv4Address src)
+{
+  if (!detector->Quarantine(src))
+    return false;
+  RecordIsolation(src);
+  return true;
+}
+
+// Counters published by --telemetrySocket
+std::string TelemetrySnapshot()
+{
+  std::ostringstream oss;
+  oss << "legit_sent=" << g_totalLegitSent << " legit_recv=" << g_totalLegitReceived
+      << " attack_sent=" << g_attackPacketsSent << " attack_dropped=" << g_attackPacketsDropped
+      << " fp_drops=" << g_fingerprintDrops
+      << " nodes=";
+  // node:tracked/blacklisted for every defended node
+  for (uint32_t i = 0; i + 1 < g_detectors.size(); ++i)
+  {
+    oss << (i ? "," : "") << i << ":" << g_detectors[i]->GetTrackedSources() << "/"
+        << g_detectors[i]->GetBlacklistedSources();
+  }
+  return oss.str();
+}
 
 void LogLegitTx(Ptr<const Packet>)
 {
@@ -102,12 +349,35 @@ void DefenseRxCallback(Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t)
     return;
 
   Ipv4Address src = header.GetSource();
+  if (g_gossipEnabled && IsGossipPacket(p))
+    return; // defense control traffic
 
   NS_LOG_INFO(Simulator::Now().GetSeconds() << "s: Packet received from " << src
                                           << " at node " << ipv4->GetObject<Node>()->GetId()
                                           << ", packet size: " << p->GetSize());
 
-  if (!g_detector->ShouldAccept(src))
+  uint32_t nodeId = ipv4->GetObject<Node>()->GetId();
+  if (g_fingerprint && g_fingerprint->IsFlagged(nodeId, src))
+  {
+    g_fingerprintDrops++;
+    g_attackPacketsDropped++;
+    RecordVerdict(src, false);
+    NS_LOG_INFO(Simulator::Now().GetSeconds() << "s: [FINGERPRINT] Dropped packet from " << src
+                                              << " at node " << nodeId);
+    return;
+  }
+
+  bool accepted = true;
+  if (g_batchTick.IsStrictlyPositive())
+    g_detectors[nodeId]->Enqueue(src); // verdict applied (and timed) at the end of the tick
+  else
+  {
+    auto begin = std::chrono::steady_clock::now();
+    accepted = g_detectors[nodeId]->ShouldAccept(src);
+    if (g_realtime.enabled)
+      RecordRealtimeDecision(begin);
+  }
+  if (!accepted)
   {
     NS_LOG_INFO(Simulator::Now().GetSeconds() << "s: [DEFENSE] Dropped packet from " << src
                                               << " at node " << ipv4->GetObject<Node>()->GetId());
@@ -116,59 +386,139 @@ void DefenseRxCallback(Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t)
   NS_LOG_INFO(Simulator::Now().GetSeconds() << "s: [DEFENSE] Accepted packet from " << src);
 }
 
+// Identity rotation strategies for the Sybil attacker
+enum SybilRotation
+{
+  ROTATE_ROUND_ROBIN, // cycle through every identity, one packet each
+  ROTATE_RANDOM,      // pick a uniformly random identity per packet
+  ROTATE_SLOW_DRIP    // bring identities into play one at a time
+};
+
+SybilRotation ParseSybilRotation(const std::string &name)
+{
+  if (name == "round-robin")
+    return ROTATE_ROUND_ROBIN;
+  if (name == "random")
+    return ROTATE_RANDOM;
+  if (name == "slow-drip")
+    return ROTATE_SLOW_DRIP;
+  NS_ABORT_MSG("Unknown Sybil rotation '" << name << "' (use round-robin, random or slow-drip)");
+  return ROTATE_ROUND_ROBIN;
+}
+
+// First identity of each attacker: 10.0.0.200 upwards for the first one,
+// 10.0.128.1 upwards for the rest of the botnet. Aborts when a range
+// reaches the node addresses (10.0.0.1 upwards), the 10.0.0.255 broadcast
+// or another attacker's range.
+std::vector<Ipv4Address> SybilIdentityRanges(uint32_t numNodes, uint32_t numAttackers, uint32_t sybilCount)
+{
+  NS_ABORT_MSG_IF(sybilCount == 0, "sybilCount must be at least 1");
+  uint32_t nodesLo = Ipv4Address("10.0.0.1").Get();
+  uint32_t nodesHi = nodesLo + numNodes - 1;
+  uint32_t broadcast = Ipv4Address("10.0.0.255").Get();
+  std::vector<Ipv4Address> first;
+  for (uint32_t b = 0; b < numAttackers; ++b)
+  {
+    uint32_t lo = b == 0 ? Ipv4Address("10.0.0.200").Get() : Ipv4Address("10.0.128.1").Get() + (b - 1) * sybilCount;
+    uint32_t hi = lo + sybilCount - 1;
+    NS_ABORT_MSG_IF(lo <= nodesHi && nodesLo <= hi,
+                    "Sybil identities " << Ipv4Address(lo) << "-" << Ipv4Address(hi) << " of attacker " << b
+                                        << " overlap the node addresses " << Ipv4Address(nodesLo) << "-"
+                                        << Ipv4Address(nodesHi) << " (lower nNodes + numAttackers below 200)");
+    NS_ABORT_MSG_IF(lo <= broadcast && broadcast <= hi,
+                    "Sybil identities " << Ipv4Address(lo) << "-" << Ipv4Address(hi) << " of attacker " << b
+                                        << " include the broadcast address " << Ipv4Address(broadcast));
+    for (uint32_t o = 0; o < b; ++o)
+    {
+      uint32_t otherLo = first[o].Get();
+      NS_ABORT_MSG_IF(lo <= otherLo + sybilCount - 1 && otherLo <= hi,
+                      "Sybil identities of attackers " << o << " and " << b << " overlap (lower sybilCount)");
+    }
+    first.push_back(Ipv4Address(lo));
+  }
+  return first;
+}
+
+// SybilApp: spoofs its source address by injecting one prebuilt broadcast
+// frame per identity straight into the attacker's Wi-Fi device.
 class SybilApp : public Application
 {
 public:
-  SybilApp() : m_index(0), m_sendEvent() {}
+  SybilApp() : m_index(0), m_activeIds(1), m_sendEvent() {}
 
-  void Setup(Ptr<Node> node, uint32_t numSybilIds)
+  void Setup(Ptr<Node> node, Ptr<NetDevice> device, uint32_t numSybilIds, SybilRotation rotation,
+             double dripInterval, double burstInterval, Ipv4Address firstId, uint32_t bot)
   {
     m_node = node;
-    uint16_t baseIp = 200;
+    m_bot = bot;
+    m_device = device;
+    m_rotation = rotation;
+    m_dripInterval = dripInterval;
+    m_burstInterval = Seconds(burstInterval);
+    m_rng = CreateObject<UniformRandomVariable>();
+
     for (uint32_t i = 0; i < numSybilIds; ++i)
     {
-      std::ostringstream oss;
-      oss << "10.0.0." << baseIp + i;
-      Ipv4Address ip(oss.str().c_str());
+      Ipv4Address ip(firstId.Get() + i);
       m_ips.push_back(ip);
+      m_frames.push_back(BuildBroadcastFrame(ip, 128, 9));
     }
   }
 
+  const std::vector<Ipv4Address> &GetIdentities() const { return m_ips; }
+
+  // Time between the application start and its first burst
+  static Time FirstBurstDelay() { return Seconds(15.0); }
+
 protected:
   virtual void StartApplication() override
   {
-    m_socket = Socket::CreateSocket(m_node, UdpSocketFactory::GetTypeId());
-    m_socket->SetAllowBroadcast(true);
-    m_socket->Bind();
-    Simulator::Schedule(Seconds(15.0), &SybilApp::SendBurst, this);
+    m_activeIds = 1;
+    m_dripStart = Simulator::Now() + FirstBurstDelay();
+    m_sendEvent = Simulator::Schedule(FirstBurstDelay(), &SybilApp::SendBurst, this);
   }
 
   virtual void StopApplication() override
   {
     if (m_sendEvent.IsRunning())
       Simulator::Cancel(m_sendEvent);
-    if (m_socket)
+  }
+
+private:
+  uint32_t NextIdentity()
+  {
+    switch (m_rotation)
+    {
+    case ROTATE_RANDOM:
+      return m_rng->GetInteger(0, m_ips.size() - 1);
+    case ROTATE_SLOW_DRIP:
     {
-      m_socket->Close();
-      m_socket = nullptr;
+      // One more identity joins the active pool every drip interval
+      uint32_t joined = 1 + static_cast<uint32_t>(
+                              (Simulator::Now() - m_dripStart).GetSeconds() / m_dripInterval);
+      m_activeIds = std::min<uint32_t>(joined, m_ips.size());
+      return m_index++ % m_activeIds;
+    }
+    case ROTATE_ROUND_ROBIN:
+    default:
+      return m_index++ % m_ips.size();
     }
   }
 
-private:
   void SendBurst()
   {
-    if (!m_socket || m_ips.empty())
+    if (!m_device || m_ips.empty())
       return;
 
     for (int i = 0; i < 6; ++i)
     {
-      Ipv4Address src = m_ips[m_index++ % m_ips.size()];
-      Ptr<Packet> pkt = Create<Packet>(128);
-      InetSocketAddress remote(Ipv4Address("255.255.255.255"), 9);
-      int sent = m_socket->SendTo(pkt, 0, remote);
-      if (sent >= 0)
+      uint32_t id = NextIdentity();
+      Ipv4Address src = m_ips[id];
+      if (SendBroadcastFrame(m_device, m_frames[id], m_ipId))
       {
         g_attackPacketsSent++;
+        g_sybilPacketsSent++;
+        RecordAttackPacket(m_bot);
         NS_LOG_INFO(Simulator::Now().GetSeconds() << "s: Attack burst pkt " << (i + 1)
                                                   << " sent from " << src << ", total sent: " << g_attackPacketsSent);
       }
@@ -177,19 +527,47 @@ private:
         NS_LOG_WARN("Failed to send attack pkt from " << src);
       }
     }
-    m_sendEvent = Simulator::Schedule(Seconds(0.02), &SybilApp::SendBurst, this);
+    m_sendEvent = Simulator::Schedule(m_burstInterval, &SybilApp::SendBurst, this);
   }
 
   Ptr<Node> m_node;
-  Ptr<Socket> m_socket;
+  Ptr<NetDevice> m_device;
+  Ptr<UniformRandomVariable> m_rng;
   std::vector<Ipv4Address> m_ips;
+  std::vector<std::vector<uint8_t>> m_frames;
+  uint16_t m_ipId{0};
+  SybilRotation m_rotation{ROTATE_ROUND_ROBIN};
+  Time m_burstInterval{Seconds(0.02)}; // 6 packets per burst
+  uint32_t m_bot{0};
+  double m_dripInterval{5.0};
+  Time m_dripStart;
   uint32_t m_index;
+  uint32_t m_activeIds;
   EventId m_sendEvent;
 };
 
+void PrintBotnetSummary()
+{
+  std::set<SybilDetector *> detectors;
+  uint64_t tracked = 0, blacklisted = 0;
+  for (uint32_t i = 0; i + 1 < g_detectors.size(); ++i)
+  {
+    if (!detectors.insert(PeekPointer(g_detectors[i])).second)
+      continue;
+    tracked += g_detectors[i]->GetTrackedSources();
+    blacklisted += g_detectors[i]->GetBlacklistedSources();
+  }
+  PrintBotnetReport(tracked, blacklisted);
+}
+
 void PrintFinalResults()
 {
   NS_LOG_INFO("PrintFinalResults called at " << Simulator::Now().GetSeconds() << "s");
+  if (g_batchTick.IsStrictlyPositive())
+  {
+    for (auto &detector : g_detectors)
+      detector->FlushBatch(); // arrivals of the last tick
+  }
   double pdr = g_totalLegitSent ? 100.0 * g_totalLegitReceived / g_totalLegitSent : 0.0;
 
   std::cout << std::fixed << std::setprecision(2);
@@ -201,7 +579,23 @@ void PrintFinalResults()
   std::cout << "Attack packets dropped:      " << g_attackPacketsDropped << "\n";
   std::cout << "================================\n";
 
-  g_detector->PrintReport();
+  if (g_detectors.front() != g_detectors.back())
+  {
+    for (uint32_t i = 0; i + 1 < g_detectors.size(); ++i)
+    {
+      if (g_detectors[i]->HasActivity())
+        g_detectors[i]->PrintReport("(node " + std::to_string(i) + ") ");
+    }
+    PrintIsolationReport(g_detectors.size() - 1);
+  }
+  else
+  {
+    g_detectors[0]->PrintReport();
+  }
+  std::cout << "Total attack packets dropped: " << g_attackPacketsDropped << "\n";
+  PrintDetectionAccuracy();
+  if (g_fingerprint)
+    g_fingerprint->PrintReport();
 
   if (pdr > 90.0)
     std::cout << "Network status: WELL PROTECTED\n";
@@ -210,55 +604,261 @@ void PrintFinalResults()
   else
     std::cout << "Network status: VULNERABLE\n";
 
+  if (g_energy.sources.GetN() > 0)
+  {
+    FinalizeEnergy();
+    PrintEnergyReport(Simulator::Now().GetSeconds(), g_totalLegitReceived,
+                      g_defenseEnabled ? DEFENSE_OBSERVE : DEFENSE_OFF);
+  }
+
+  if (g_realtime.enabled)
+  {
+    g_realtime.finish = std::chrono::steady_clock::now();
+    PrintRealtimeReport(g_detectors.size() - 1);
+  }
+
+  if (g_convergence.IsEnabled())
+    g_convergence.PrintReport();
+
+  if (g_botnet.size() > 1)
+    PrintBotnetSummary();
+
+  if (!g_flows.empty())
+    PrintTrafficReport(Simulator::Now().GetSeconds() - 2.0);
+
   std::cout << std::flush;
 }
 
+// legitSources sources at legitRate plus one attacker cycling sybilIds
+// spoofed identities at attackRate in total
+void RunSybilBenchmark(uint32_t legitSources, double legitRate, uint32_t sybilIds, double attackRate,
+                       double seconds, Time tick)
+{
+  BenchmarkArrivals arrivals;
+  for (uint32_t i = 0; i < legitSources; ++i)
+    AddBenchmarkStream(arrivals, Ipv4Address(0x0a000001 + i), legitRate, double(i) / legitSources, seconds);
+  for (uint32_t i = 0; i < sybilIds; ++i)
+  {
+    Ipv4Address id(Ipv4Address("10.0.0.200").Get() + i);
+    g_attackerAddresses.insert(id);
+    AddBenchmarkStream(arrivals, id, attackRate / sybilIds, double(i) / sybilIds, seconds);
+  }
+
+  std::ostringstream workload;
+  workload << legitSources << " sources at " << legitRate << " pkt/s, " << sybilIds << " Sybil identities at "
+           << attackRate << " pkt/s, " << seconds << " s";
+  RunDetectorBenchmark<SybilDetector>(
+      arrivals, workload.str(), tick,
+      [](SybilDetector &d, Ipv4Address src, Time now) { d.ShouldAccept(src, now); },
+      [](SybilDetector &d, Ipv4Address src, Time now) { d.Enqueue(src, now); });
+}
+
 int main(int argc, char *argv[])
 {
   uint32_t nNodes = 10;
   uint32_t sybilCount = 6;
   bool enablePcap = true;
+  bool lean = false;
+  bool perfReport = false;
+  bool comparePerf = false;
+  uint32_t batchTickMs = 0;
+  bool benchDetector = false;
+  uint32_t benchSources = 50;
+  double benchSeconds = 60.0;
+  std::string sybilRotation = "round-robin";
+  double dripInterval = 5.0;
+  bool enableDefense = true;
+  bool enableFingerprint = false;
+  double attackRate = 300.0;
+  uint32_t trafficFlows = 0;
+  std::string trafficPairs = "";
+  std::string trafficSource = "cbr";
+  double trafficRate = 10.0;
+  uint32_t trafficPacketSize = 512;
+  uint32_t numAttackers = 1;
+  std::string attackerPlacement = "clustered";
+  double attackStagger = 0.0;
+  bool realtime = false;
+  uint32_t rtDeadlineMs = 10;
+  bool convergence = false;
+  double convergenceBatch = 1.0;
+  double convergencePrecision = 0.05;
+  double convergenceMinTime = 10.0;
+  uint32_t convergenceMinBatches = 10;
+  std::string mobilityIn = "";
+  std::string mobilityOut = "";
+  double mobilityLookahead = 10.0;
+  std::string telemetrySocket = "";
+  uint32_t telemetryIntervalMs = 500;
+  bool enableEnergy = false;
+  double initialEnergyJ = 100.0;
+  double energyInterval = 1.0;
+  bool perNodeDefense = false;
+  double gossipInterval = 0.5;
+  double gossipBatchDelay = 0.05;
+  uint32_t gossipTtl = 2;
 
   CommandLine cmd;
   cmd.AddValue("nNodes", "Number of legitimate nodes", nNodes);
   cmd.AddValue("sybilCount", "Number of Sybil identities", sybilCount);
   cmd.AddValue("enablePcap", "Enable PCAP capture", enablePcap);
+  cmd.AddValue("lean", "Headless batch mode: no NetAnim, PCAP or logging, counters only", lean);
+  cmd.AddValue("perfReport", "Report run time and peak memory", perfReport);
+  cmd.AddValue("comparePerf", "Run full and then lean in child processes and print the ratios", comparePerf);
+  cmd.AddValue("sybilRotation", "Identity rotation: round-robin, random or slow-drip", sybilRotation);
+  cmd.AddValue("dripInterval", "Seconds between new identities in slow-drip rotation", dripInterval);
+  cmd.AddValue("enableDefense", "Enable the Sybil detectors", enableDefense);
+  cmd.AddValue("attackRate", "Sybil attack rate in packets per second", attackRate);
+  cmd.AddValue("trafficFlows", "Extra legitimate flows between random node pairs", trafficFlows);
+  cmd.AddValue("trafficPairs", "Extra flows between given pairs, e.g. 0-5,3-7 (overrides trafficFlows)", trafficPairs);
+  cmd.AddValue("trafficSource", "Extra flow source: cbr, poisson or onoff", trafficSource);
+  cmd.AddValue("trafficRate", "Packets per second per extra flow", trafficRate);
+  cmd.AddValue("trafficPacketSize", "Packet size in bytes for extra flows", trafficPacketSize);
+  cmd.AddValue("numAttackers", "Number of Sybil attacker nodes", numAttackers);
+  cmd.AddValue("attackerPlacement", "Attacker placement: clustered, uniform or mobile", attackerPlacement);
+  cmd.AddValue("attackStagger", "Seconds between the start times of successive attackers", attackStagger);
+  cmd.AddValue("realtime", "Run under the real-time scheduler and report decision timing", realtime);
+  cmd.AddValue("rtDeadlineMs", "Lateness in ms after which a decision counts as a deadline miss", rtDeadlineMs);
+  cmd.AddValue("convergence", "Stop early once PDR and drop rate have converged", convergence);
+  cmd.AddValue("convergenceBatch", "Seconds per batch for the batch-means estimate", convergenceBatch);
+  cmd.AddValue("convergencePrecision", "Relative 95% CI half-width at which a metric has converged", convergencePrecision);
+  cmd.AddValue("convergenceMinTime", "Earliest simulation time in seconds to stop at", convergenceMinTime);
+  cmd.AddValue("convergenceMinBatches", "Batches required per metric before stopping", convergenceMinBatches);
+  cmd.AddValue("mobilityIn", "Replay node movement from a binary waypoint trace", mobilityIn);
+  cmd.AddValue("mobilityOut", "Write the random-walk movement to a waypoint trace and exit", mobilityOut);
+  cmd.AddValue("mobilityLookahead", "Seconds of waypoints kept loaded when replaying", mobilityLookahead);
+  cmd.AddValue("telemetrySocket", "Unix datagram socket path for live counters (empty = off)", telemetrySocket);
+  cmd.AddValue("telemetryIntervalMs", "Wall-clock milliseconds between telemetry datagrams", telemetryIntervalMs);
+  cmd.AddValue("enableEnergy", "Install battery and Wi-Fi radio energy models", enableEnergy);
+  cmd.AddValue("initialEnergyJ", "Initial battery energy per node in joules", initialEnergyJ);
+  cmd.AddValue("energyInterval", "Seconds between residual energy samples", energyInterval);
+  cmd.AddValue("enableFingerprint", "Enable PHY (RSSI, MAC) fingerprint detection", enableFingerprint);
+  cmd.AddValue("fpRssiTolerance", "RSSI band in dB treated as one transmitter", g_fpRssiTolerance);
+  cmd.AddValue("fpIdentityThreshold", "Distinct IPs per fingerprint before flagging", g_fpIdentityThreshold);
+  cmd.AddValue("detectionMode", "Detection: fixed (rate/burst limits) or ewma (learned baseline)", g_detectionMode);
+  cmd.AddValue("ewmaAlpha", "EWMA smoothing factor", g_ewmaAlpha);
+  cmd.AddValue("ewmaK", "Baseline deviations before a source is flagged", g_ewmaK);
+  cmd.AddValue("ewmaWarmup", "Seconds of baseline learning before verdicts", g_ewmaWarmup);
+  cmd.AddValue("batchTickMs", "Queue arrivals and judge them in batches every this many ms (0 = per packet)", batchTickMs);
+  cmd.AddValue("benchDetector", "Benchmark per-packet against batched decisions at attackRate and exit", benchDetector);
+  cmd.AddValue("benchSources", "Legitimate sources in the detector benchmark", benchSources);
+  cmd.AddValue("benchSeconds", "Seconds of arrivals in the detector benchmark", benchSeconds);
+  cmd.AddValue("blacklistThreshold", "Violations before a source is blacklisted", g_blacklistThreshold);
+  cmd.AddValue("perNodeDefense", "Give each node its own detector instead of one shared view", perNodeDefense);
+  cmd.AddValue("enableGossip", "Broadcast blacklist digests to neighbours (implies perNodeDefense)", g_gossipEnabled);
+  cmd.AddValue("gossipInterval", "Minimum seconds between digests from one node", gossipInterval);
+  cmd.AddValue("gossipBatchDelay", "Seconds to batch new blacklist entries before sending", gossipBatchDelay);
+  cmd.AddValue("gossipTtl", "Hops a blacklist entry is re-gossiped", gossipTtl);
+  cmd.AddValue("gossipQuorum", "Distinct neighbour transmitters (MAC) needed before quarantining a source", g_gossipQuorum);
   cmd.Parse(argc, argv);
+  g_defenseEnabled = enableDefense;
 
-  LogComponentEnable("SybilDefenseSimulation", LOG_LEVEL_INFO);
+  if (benchDetector)
+  {
+    RunSybilBenchmark(benchSources, 1.25, sybilCount, attackRate, benchSeconds,
+                      MilliSeconds(std::max(batchTickMs, 1u)));
+    return 0;
+  }
 
-  g_detector = CreateObject<SybilDetector>();
+  if (comparePerf)
+  {
+    perfReport = true;
+    if (!ForkPerfComparison(lean))
+      return 0;
+  }
+
+  g_batchTick = MilliSeconds(batchTickMs);
+  NS_ABORT_MSG_IF(batchTickMs > 0 && g_detectionMode != "fixed", "Batched evaluation supports the fixed detector only");
+
+  if (realtime)
+  {
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::RealtimeSimulatorImpl"));
+    Config::SetDefault("ns3::RealtimeSimulatorImpl::SynchronizationMode", StringValue("BestEffort"));
+    g_realtime.enabled = true;
+    g_realtime.deadline = MilliSeconds(rtDeadlineMs);
+  }
+
+  if (lean)
+    enablePcap = false;
+  else
+    LogComponentEnable("SybilDefenseSimulation", LOG_LEVEL_INFO);
+
+  NS_ABORT_MSG_IF(numAttackers == 0, "At least one attacker required");
+  std::vector<Ipv4Address> firstIds = SybilIdentityRanges(nNodes + numAttackers, numAttackers, sybilCount);
+  NS_ABORT_MSG_UNLESS(attackerPlacement == "clustered" || attackerPlacement == "uniform"
+                          || attackerPlacement == "mobile",
+                      "Unknown attacker placement '" << attackerPlacement << "' (use clustered, uniform or mobile)");
 
   NodeContainer nodes;
-  nodes.Create(nNodes + 1);
-  Ptr<Node> attacker = nodes.Get(nNodes);
+  nodes.Create(nNodes + numAttackers);
 
-  NodeContainer legitNodes;
-  for (uint32_t i = 0; i < nNodes; ++i)
-    legitNodes.Add(nodes.Get(i));
+  NodeContainer legitNodes, attackers;
+  for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    (i < nNodes ? legitNodes : attackers).Add(nodes.Get(i));
 
   InternetStackHelper internet;
   AodvHelper aodv;
   internet.SetRoutingHelper(aodv);
   internet.Install(nodes);
 
-  MobilityHelper mobility;
-  mobility.SetPositionAllocator("ns3::GridPositionAllocator",
-                                "MinX", DoubleValue(-100.0),
-                                "MinY", DoubleValue(-100.0),
-                                "DeltaX", DoubleValue(50.0),
-                                "DeltaY", DoubleValue(50.0),
-                                "GridWidth", UintegerValue(5),
-                                "LayoutType", StringValue("RowFirst"));
-  mobility.SetMobilityModel("ns3::RandomWalk2dMobilityModel",
-                            "Bounds", RectangleValue(Rectangle(-100, 150, -100, 150)),
-                            "Speed", StringValue("ns3::UniformRandomVariable[Min=0.5|Max=1.0]"));
-  mobility.Install(legitNodes);
-
-  MobilityHelper mobAttacker;
-  mobAttacker.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-  mobAttacker.Install(attacker);
-  attacker->GetObject<MobilityModel>()->SetPosition(Vector(300, 300, 0));
+  if (!mobilityIn.empty())
+  {
+    NS_ABORT_MSG_UNLESS(g_mobilityReader.Open(mobilityIn, nodes, mobilityLookahead),
+                        "Cannot read mobility trace " << mobilityIn);
+    std::cout << "Mobility replayed from " << mobilityIn << "\n";
+  }
+  else
+  {
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator("ns3::GridPositionAllocator",
+                                  "MinX", DoubleValue(-100.0),
+                                  "MinY", DoubleValue(-100.0),
+                                  "DeltaX", DoubleValue(50.0),
+                                  "DeltaY", DoubleValue(50.0),
+                                  "GridWidth", UintegerValue(5),
+                                  "LayoutType", StringValue("RowFirst"));
+    mobility.SetMobilityModel("ns3::RandomWalk2dMobilityModel",
+                              "Bounds", RectangleValue(Rectangle(-100, 150, -100, 150)),
+                              "Speed", StringValue("ns3::UniformRandomVariable[Min=0.5|Max=1.0]"));
+    mobility.Install(legitNodes);
+
+    if (attackerPlacement == "mobile")
+    {
+      mobility.Install(attackers);
+    }
+    else
+    {
+      // The first attacker keeps the original spot at (300, 300); the rest
+      // gather around it or spread over the legitimate area
+      MobilityHelper mobAttacker;
+      mobAttacker.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+      mobAttacker.Install(attackers);
+      Ptr<UniformRandomVariable> pos = CreateObject<UniformRandomVariable>();
+      for (uint32_t b = 0; b < numAttackers; ++b)
+      {
+        Vector at(300, 300, 0);
+        if (attackerPlacement == "uniform")
+          at = Vector(pos->GetValue(-100, 150), pos->GetValue(-100, 150), 0);
+        else if (b > 0)
+          at = Vector(300 + pos->GetValue(-25, 25), 300 + pos->GetValue(-25, 25), 0);
+        attackers.Get(b)->GetObject<MobilityModel>()->SetPosition(at);
+      }
+    }
+  }
+
+  // Trace generator: run the mobility alone and write it out
+  if (!mobilityOut.empty())
+  {
+    MobilityTraceWriter writer;
+    NS_ABORT_MSG_UNLESS(writer.Open(mobilityOut, nodes), "Cannot write mobility trace " << mobilityOut);
+    Simulator::Stop(Seconds(121.0));
+    Simulator::Run();
+    writer.Finish();
+    Simulator::Destroy();
+    std::cout << "Wrote " << writer.GetRecords() << " waypoints for " << nodes.GetN()
+              << " nodes to " << mobilityOut << "\n";
+    return 0;
+  }
 
   WifiHelper wifi;
   wifi.SetStandard(WIFI_STANDARD_80211b);
@@ -274,22 +874,34 @@ int main(int argc, char *argv[])
   mac.SetType("ns3::AdhocWifiMac");
 
   NetDeviceContainer devices = wifi.Install(phy, mac, nodes);
+  if (enableEnergy)
+    InstallEnergy(nodes, devices, nNodes, initialEnergyJ, energyInterval, "sybil-defense-energy.csv");
 
-  Ptr<NetDevice> attackerDev = devices.Get(nNodes);
-  Ptr<WifiNetDevice> wifiDev = DynamicCast<WifiNetDevice>(attackerDev);
-  if (wifiDev)
+  for (uint32_t b = 0; b < numAttackers; ++b)
   {
-    Ptr<YansWifiPhy> attackerPhy = DynamicCast<YansWifiPhy>(wifiDev->GetPhy());
-    if (attackerPhy)
+    Ptr<WifiNetDevice> wifiDev = DynamicCast<WifiNetDevice>(devices.Get(nNodes + b));
+    if (wifiDev)
     {
-      attackerPhy->SetTxPowerStart(40.0);
-      attackerPhy->SetTxPowerEnd(40.0);
+      Ptr<YansWifiPhy> attackerPhy = DynamicCast<YansWifiPhy>(wifiDev->GetPhy());
+      if (attackerPhy)
+      {
+        attackerPhy->SetTxPowerStart(40.0);
+        attackerPhy->SetTxPowerEnd(40.0);
+      }
     }
   }
 
   Ipv4AddressHelper ipAddr;
   ipAddr.SetBase("10.0.0.0", "255.255.255.0");
   Ipv4InterfaceContainer interfaces = ipAddr.Assign(devices);
+  g_botnet.resize(numAttackers);
+  for (uint32_t b = 0; b < numAttackers; ++b)
+  {
+    g_botnet[b].node = attackers.Get(b);
+    g_botnet[b].type = "sybil";
+    g_botnet[b].start = Seconds(15.0 + b * attackStagger);
+    RegisterBotAddress(b, interfaces.GetAddress(nNodes + b));
+  }
 
   UdpEchoServerHelper server(9);
   ApplicationContainer serverApps = server.Install(nodes.Get(0));
@@ -304,41 +916,117 @@ int main(int argc, char *argv[])
   clientApps.Start(Seconds(2.0));
   clientApps.Stop(Seconds(120.0));
 
+  if (trafficFlows > 0 || !trafficPairs.empty())
+    InstallTrafficMatrix(nodes, interfaces, nNodes, trafficFlows, trafficPairs, trafficSource,
+                         trafficRate, trafficPacketSize, 2.0, 120.0);
+
   clientApps.Get(0)->TraceConnectWithoutContext("Tx", MakeCallback(&LogLegitTx));
   serverApps.Get(0)->TraceConnectWithoutContext("Rx", MakeCallback(&LogLegitRx));
 
-  for (uint32_t i = 0; i < nNodes; ++i)
+  perNodeDefense = perNodeDefense || g_gossipEnabled;
+  g_detectors.assign(nNodes + 1, CreateObject<SybilDetector>());
+  for (uint32_t i = 0; i < nNodes && perNodeDefense; ++i)
+  {
+    Ptr<SybilDetector> detector = CreateObject<SybilDetector>();
+    Ptr<BlacklistGossipApp> gossip;
+    if (g_gossipEnabled)
+    {
+      gossip = CreateObject<BlacklistGossipApp>();
+      gossip->Setup(MakeBoundCallback(&QuarantineSource, detector),
+                    gossipInterval, gossipBatchDelay, gossipTtl);
+      nodes.Get(i)->AddApplication(gossip);
+      gossip->SetStartTime(Seconds(0.0));
+      gossip->SetStopTime(Seconds(120.0));
+    }
+    detector->SetBlacklistCallback(MakeBoundCallback(&OnLocalBlacklist, gossip));
+    g_detectors[i] = detector;
+  }
+
+  for (uint32_t i = 0; i < nNodes && enableDefense; ++i)
   {
     Ptr<Ipv4> ipv4 = nodes.Get(i)->GetObject<Ipv4>();
     ipv4->TraceConnectWithoutContext("Rx", MakeCallback(&DefenseRxCallback));
   }
 
-  Ptr<SybilApp> attackerApp = CreateObject<SybilApp>();
-  attackerApp->Setup(attacker, sybilCount);
-  attacker->AddApplication(attackerApp);
-  attackerApp->SetStartTime(Seconds(15.0));
-  attackerApp->SetStopTime(Seconds(120.0));
+  if (enableFingerprint && enableDefense)
+  {
+    g_fingerprint = CreateObject<PhyFingerprintDetector>();
+    g_fingerprint->Resize(nNodes);
+    for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      Config::ConnectWithoutContext("/NodeList/" + std::to_string(i) +
+                                        "/DeviceList/*/$ns3::WifiNetDevice/Phy/MonitorSnifferRx",
+                                    MakeBoundCallback(&FingerprintSnifferRx, i));
+    }
+  }
+
+  for (uint32_t b = 0; b < numAttackers; ++b)
+  {
+    Ptr<SybilApp> attackerApp = CreateObject<SybilApp>();
+    attackerApp->Setup(attackers.Get(b), devices.Get(nNodes + b), sybilCount, ParseSybilRotation(sybilRotation),
+                       dripInterval, 6.0 / attackRate, firstIds[b], b);
+    attackers.Get(b)->AddApplication(attackerApp);
+    for (const Ipv4Address &ip : attackerApp->GetIdentities())
+      RegisterBotAddress(b, ip);
+    attackerApp->SetStartTime(g_botnet[b].start);
+    attackerApp->SetStopTime(Seconds(120.0));
+  }
 
   if (enablePcap)
     phy.EnablePcapAll("sybil-defense");
 
-  AnimationInterface anim("sybil-defense.xml");
-  for (uint32_t i = 0; i < nNodes; i++)
+  // NetAnim tags every packet, so lean runs go without it
+  std::unique_ptr<AnimationInterface> anim;
+  if (!lean)
+  {
+    anim = std::make_unique<AnimationInterface>("sybil-defense.xml");
+    for (uint32_t i = 0; i < nNodes; i++)
+    {
+      anim->UpdateNodeColor(nodes.Get(i), 0, 255, 0);
+      anim->UpdateNodeSize(nodes.Get(i)->GetId(), 25, 25);
+    }
+    for (uint32_t b = 0; b < numAttackers; b++)
+    {
+      anim->UpdateNodeColor(attackers.Get(b), 255, 0, 0);
+      anim->UpdateNodeSize(attackers.Get(b)->GetId(), 50, 50);
+    }
+  }
+
+  if (!telemetrySocket.empty() && !StartTelemetry(telemetrySocket, telemetryIntervalMs, &TelemetrySnapshot))
+    std::cout << "Telemetry disabled: cannot open socket for " << telemetrySocket << "\n";
+
+  if (convergence)
   {
-    anim.UpdateNodeColor(nodes.Get(i), 0, 255, 0);
-    anim.UpdateNodeSize(nodes.Get(i)->GetId(), 25, 25);
+    g_convergence.Setup(convergenceBatch, convergencePrecision, convergenceMinTime, convergenceMinBatches);
+    g_convergence.AddMetric("PDR", &g_totalLegitReceived, &g_totalLegitSent);
+    if (enableDefense)
+      g_convergence.AddMetric("Attack drops/packet", &g_attackPacketsDropped, &g_attackPacketsSent);
+    // Batches begin with the earliest Sybil burst
+    Time attackStart = Seconds(121.0);
+    for (const BotnetMember &m : g_botnet)
+      attackStart = std::min(attackStart, m.start + SybilApp::FirstBurstDelay());
+    g_convergence.Start(attackStart);
   }
-  anim.UpdateNodeColor(attacker, 255, 0, 0);
-  anim.UpdateNodeSize(attacker->GetId(), 50, 50);
 
+  if (realtime)
+    Simulator::ScheduleNow(&StartRealtimeClock);
   Simulator::Schedule(Seconds(121.0), &PrintFinalResults);
   Simulator::Stop(Seconds(121.0));
 
+  auto wallStart = std::chrono::steady_clock::now();
   Simulator::Run();
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  if (g_convergence.StoppedEarly())
+    PrintFinalResults();
 
   std::cout << "Simulation completed." << std::endl << std::flush;
 
+  StopTelemetry();
+  anim.reset();
   Simulator::Destroy();
 
+  if (lean || perfReport)
+    PrintRunPerformance(lean, wallSeconds);
+
   return 0;
 }